@@ -22,7 +22,7 @@ Requires:   slurm
 %autosetup -n %{name}-%{version}
 
 %build
-gcc -lslurm %{name}.c -o %{name}
+gcc -lslurm -lpthread %{name}.c -o %{name}
 
 %install
 mkdir -p %{buildroot}%{_bindir}
@@ -5,6 +5,11 @@
  * Note     : Some part of this code taken from slurm api man pages
  *******************************************************************/
 
+/* the spart server reads the user of a client from its socket */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
 #include <grp.h>
 #include <limits.h>
 #include <pwd.h>
@@ -14,188 +19,189 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
 #include "spart.h"
+#include "spart_hash.h"
 #include "spart_string.h"
 #include "spart_data.h"
+#include "spart_user.h"
+#include "spart_fetch.h"
+#include "spart_cache.h"
+#include "spart_server.h"
+#include "spart_record.h"
+#include "spart_lib.h"
 #include "spart_output.h"
+#include "spart_watch.h"
+#include "spart_metrics.h"
+#include "spart_batch.h"
 
 /* ========== MAIN ========== */
 int main(int argc, char *argv[]) {
   uint32_t i, j;
-  int k, m, n;
+  int k, m;
   int total_width = 0;
 
-/* Slurm defined types */
-#if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
-  slurm_conf_t *conf_info_msg_ptr = NULL;
-#else
-  slurm_ctl_conf_t *conf_info_msg_ptr = NULL;
-#endif
-  partition_info_msg_t *part_buffer_ptr = NULL;
-  partition_info_t *part_ptr = NULL;
-  node_info_msg_t *node_buffer_ptr = NULL;
-  job_info_msg_t *job_buffer_ptr = NULL;
-
-#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
-    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
-    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
-  void **db_conn = NULL;
-  slurmdb_assoc_cond_t assoc_cond;
-  List assoc_list = NULL;
-  ListIterator itr = NULL;
-
-  List qosn_list = NULL;
-  ListIterator itr_qosn = NULL;
+  /* the slurm data and the partitions */
+  sp_lib_t splib;
 
-  slurmdb_assoc_rec_t *assoc;
-
-  List qos_list = NULL;
-  ListIterator itr_qos = NULL;
-
-  char *qos = NULL;
-  char *qos2 = NULL;
-#else
-  char sh_str[SPART_INFO_STRING_SIZE];
-  char *p_str = NULL;
-  char *t_str = NULL;
-#endif
   char re_str[SPART_INFO_STRING_SIZE];
   FILE *fo;
 
-  int user_acct_count = 0;
-  char **user_acct = NULL;
-
-  int user_qos_count = 0;
-  char **user_qos = NULL;
+  sp_user_info_t spuser;
+  uint16_t private_data = 0;
 
-  int user_group_count = SPART_MAX_GROUP_SIZE;
-  char **user_group = NULL;
-
-  uint32_t mem, cpus, min_mem, max_mem;
-  uint32_t max_cpu, min_cpu, free_cpu, free_node;
-  uint64_t max_mem_per_cpu = 0;
-  uint64_t def_mem_per_cpu = 0;
-  /* These values are default/unsetted values */
-  const uint32_t default_min_nodes = 0, default_max_nodes = UINT_MAX;
-  const uint64_t default_max_mem_per_cpu = 0;
-  const uint64_t default_def_mem_per_cpu = 0;
-  const uint32_t default_max_cpus_per_node = UINT_MAX;
-  const uint32_t default_mjt_time = INFINITE;
-  char *default_qos = "normal";
-
-  uint16_t alloc_cpus = 0;
-  char mem_result[SPART_INFO_STRING_SIZE];
-  char strtmp[SPART_INFO_STRING_SIZE];
-  char user_name[SPART_INFO_STRING_SIZE];
-  int user_id;
   char legends[SPART_INFO_STRING_SIZE];
-#ifdef __slurmdb_cluster_rec_t_defined
-  char cluster_name[SPART_INFO_STRING_SIZE];
-#endif
-
-#ifdef SPART_COMPILE_FOR_UHEM
-  char *reason;
-#endif
 
-  uint32_t state;
   uint16_t tmp_lenght = 0;
   int show_max_mem = 0;
-  int show_max_mem_per_cpu = 0;
-  int show_max_cpus_per_node = 0;
-  int show_def_mem_per_cpu = 0;
   uint16_t show_partition = 0;
-  uint16_t show_partition_qos = 0;
-  uint16_t show_min_nodes = 0;
-  uint16_t show_max_nodes = 0;
-  uint16_t show_mjt_time = 0;
-  uint16_t show_djt_time = 0;
+  /* the SPART_SET_ limits of the partitions, to show the limit columns */
+  uint16_t limits_set = 0;
   int show_parameter_L = 0;
-  int show_gres = 0;
-  int show_features = 0;
   int show_all_partition = 0;
   int show_given_partition = 0;
   int show_as_date = 0;
-  int show_cluster_name = 0;
-  int show_min_mem_gb = 0;
-  int show_min_core = 0;
-  int show_my_running = 1;
-  int show_my_waiting_resource = 1;
-  int show_my_waiting_other = 1;
-  int show_my_total = 1;
+  int show_my_jobs = 1;
   int show_simple = 0;
   int show_verbose = 0;
+  int show_json = 0;
+  const char *metrics_file = NULL;
 
   uint16_t partname_lenght = 0;
 #ifdef __slurmdb_cluster_rec_t_defined
   uint16_t clusname_lenght = 0;
 #endif
 
-  char partition_str[SPART_INFO_STRING_SIZE];
-  char job_parts_str[SPART_INFO_STRING_SIZE];
   char given_part_list[SPART_INFO_STRING_SIZE];
+  const char *given_format = NULL;
+  sp_hash_t given_parts;
 
   sp_part_info_t *spData = NULL;
   uint32_t partition_count = 0;
-
-  uint16_t sp_gres_count = 0;
-  sp_gres_info_t spgres[SPART_GRES_ARRAY_SIZE];
-
-  uint16_t sp_features_count = 0;
-  sp_gres_info_t spfeatures[SPART_GRES_ARRAY_SIZE];
+  uint32_t first = 0; /* the first visible partition */
+  sp_plan_t spplan;
+  const sp_strpool_t *strs = NULL;
+  sp_user_jobs_list_t user_jobs = {0, 0, NULL};
+
+  int from_cache = 0;
+  int cache_write = 0;
+  int hidden_loaded = 0;
+#ifdef SPART_USE_SNAPSHOT
+  sp_snapshot_t spsnap;
+#endif
+#ifdef SPART_CACHE_DIR
+  char cache_path[SPART_INFO_STRING_SIZE];
+#endif
+#if defined(SPART_SERVER_SOCKET) || defined(SPART_CACHE_DIR)
+  int use_cache = 0;
+#endif
 
   sp_headers_t spheaders;
+  sp_strbuf_t spout;
+  sp_json_t spjson;
+
+  /* the watch mode */
+  int watch_seconds = 0;
+  uint32_t rounds = 0;
+  char note[SPART_INFO_STRING_SIZE];
+  sp_headers_t spheaders_opt;
+  int show_all_opt = 0;
+  sp_watch_t spwatch;
+  /* the batch mode */
+  sp_batch_t spbatch;
+  /* the record and the replay of the slurm data */
+  const char *record_file = NULL;
+  const char *replay_file = NULL;
+  sp_record_t sprec;
+#ifdef SPART_SHOW_PROFILE
+  struct rusage usage;
+#endif
 
   legends[0] = 0;
+  memset(&spbatch, 0, sizeof(sp_batch_t));
 
   int show_info = 0;
-  /* Get username */
-  gid_t *groupIDs = NULL;
-  struct passwd *pw;
-  struct group *gr;
 
 #if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
   slurm_init(NULL);
 #endif
 
-  pw = getpwuid(geteuid());
-  sp_strn2cpy(user_name, SPART_INFO_STRING_SIZE, pw->pw_name,
-              SPART_INFO_STRING_SIZE);
-  user_id = pw->pw_uid;
-
-  groupIDs = malloc(user_group_count * sizeof(gid_t));
-  if (groupIDs == NULL) {
-    slurm_perror("Can not allocate User group list");
-    exit(1);
-  }
-
-  if (getgrouplist(user_name, pw->pw_gid, groupIDs, &user_group_count) == -1) {
-    slurm_perror("Can not read User group list");
-    exit(1);
-  }
-
-  user_group = malloc(user_group_count * sizeof(char *));
-  for (k = 0; k < user_group_count; k++) {
-    gr = getgrgid(groupIDs[k]);
-    if (gr != NULL) {
-      user_group[k] = malloc(SPART_INFO_STRING_SIZE * sizeof(char));
-      sp_strn2cpy(user_group[k], SPART_INFO_STRING_SIZE, gr->gr_name,
-                  SPART_INFO_STRING_SIZE);
-    }
-  }
-
-  free(groupIDs);
+  /* Get username and groups */
+  sp_user_get(&spuser, geteuid());
 
   /* Set default column visibility */
   sp_headers_set_defaults(&spheaders);
 
   for (k = 1; k < argc; k++) {
+#ifdef SPART_SERVER_SOCKET
+    if (strncmp(argv[k], "--server", 9) == 0) {
+      sp_server_run(((k + 1) < argc) ? argv[k + 1] : NULL);
+      exit(0);
+    }
+#endif
+    if (strncmp(argv[k], "--watch", 8) == 0) {
+      if ((k + 1) < argc) watch_seconds = atoi(argv[k + 1]);
+      if (watch_seconds <= 0) {
+        printf("\nParameter --watch requires the seconds!\n");
+        sp_spart_usage();
+        printf("\nParameter --watch requires the seconds!\n");
+        exit(1);
+      }
+      k++;
+      continue;
+    }
+    if (strncmp(argv[k], "--metrics", 10) == 0) {
+      if ((k + 1) >= argc) {
+        printf("\nParameter --metrics requires the file name!\n");
+        sp_spart_usage();
+        printf("\nParameter --metrics requires the file name!\n");
+        exit(1);
+      }
+      metrics_file = argv[k + 1];
+      k++;
+      continue;
+    }
+    if (strncmp(argv[k], "--record", 9) == 0) {
+      if ((k + 1) >= argc) {
+        printf("\nParameter --record requires the file name!\n");
+        sp_spart_usage();
+        printf("\nParameter --record requires the file name!\n");
+        exit(1);
+      }
+      record_file = argv[k + 1];
+      k++;
+      continue;
+    }
+    if (strncmp(argv[k], "--replay", 9) == 0) {
+      if ((k + 1) >= argc) {
+        printf("\nParameter --replay requires the file name!\n");
+        sp_spart_usage();
+        printf("\nParameter --replay requires the file name!\n");
+        exit(1);
+      }
+      replay_file = argv[k + 1];
+      k++;
+      continue;
+    }
+    if (strncmp(argv[k], "--batch", 8) == 0) {
+      if ((k + 2) >= argc) {
+        printf("\nParameter --batch requires the users and the directory!\n");
+        sp_spart_usage();
+        printf("\nParameter --batch requires the users and the directory!\n");
+        exit(1);
+      }
+      spbatch.list = argv[k + 1];
+      spbatch.dir = argv[k + 2];
+      k += 2;
+      continue;
+    }
     if (argv[k][0] == '-') {
       for (m = 1; m < strlen(argv[k]); m++) {
         switch (argv[k][m]) {
           case 'm':
             show_max_mem = 1;
-            spheaders.min_core.column_width = 8;
-            spheaders.min_mem_gb.column_width = 10;
+            sp_headers_set_long_width(&spheaders);
             break;
           case 'a':
             show_partition |= SHOW_ALL;
@@ -219,18 +225,31 @@ int main(int argc, char *argv[]) {
               exit(1);
             }
             break;
+          case 'o':
+            if ((k + 1) < argc) {
+              given_format = argv[k + 1];
+              m = INT_MAX;
+              k++;
+              continue;
+            } else {
+              printf("\nParameter -o requires column name(s)!\n");
+              sp_spart_usage();
+              printf("\nParameter -o requires column name(s)!\n");
+              exit(1);
+            }
+            break;
 #ifdef __slurmdb_cluster_rec_t_defined
           case 'c':
             show_partition |= SHOW_FEDERATION;
             show_partition &= (~SHOW_LOCAL);
-            spheaders.cluster_name.visible = 1;
+            spheaders.col[SPART_COL_CLUSTER].visible = 1;
             break;
 #endif
           case 'g':
-            spheaders.gres.visible = 1;
+            spheaders.col[SPART_COL_GRES].visible = 1;
             break;
           case 'f':
-            spheaders.features.visible = 1;
+            spheaders.col[SPART_COL_FEATURES].visible = 1;
             break;
           case 'i':
             show_info = 1;
@@ -238,39 +257,20 @@ int main(int argc, char *argv[]) {
           case 'v':
             show_verbose = 1;
             break;
+          case 'j':
+            show_json = 1;
+            break;
           case 't':
             show_as_date = 1;
             break;
           case 's':
-            show_gres = 0;
-            show_min_nodes = 0;
-            show_max_nodes = 0;
-            show_max_cpus_per_node = 0;
-            show_max_mem_per_cpu = 0;
-            show_def_mem_per_cpu = 0;
-            show_mjt_time = 0;
-            show_djt_time = 0;
-            show_partition_qos = 0;
             show_parameter_L = 0;
             show_simple = 1;
-            spheaders.min_nodes.visible = 0;
-            spheaders.max_nodes.visible = 0;
-            spheaders.max_cpus_per_node.visible = 0;
-            spheaders.max_mem_per_cpu.visible = 0;
-            spheaders.def_mem_per_cpu.visible = 0;
-            spheaders.djt_time.visible = 0;
-            spheaders.mjt_time.visible = 0;
-            spheaders.min_core.visible = 0;
-            spheaders.min_mem_gb.visible = 0;
-            spheaders.partition_qos.visible = 0;
-            spheaders.gres.visible = 0;
-            spheaders.features.visible = 0;
+            sp_headers_hide_rule(&spheaders, SPART_RULE_DETAIL);
             break;
           case 'J':
-            show_my_running = 0;
-            show_my_waiting_resource = 0;
-            show_my_waiting_other = 0;
-            show_my_total = 0;
+            show_my_jobs = 0;
+            sp_headers_set_group(&spheaders, SPART_GROUP_MY_JOBS, 0);
             break;
           case 'l':
             sp_headers_set_parameter_L(&spheaders);
@@ -280,15 +280,6 @@ int main(int argc, char *argv[]) {
 #else
             show_partition |= SHOW_ALL;
 #endif
-            show_gres = 1;
-            show_min_nodes = 1;
-            show_max_nodes = 1;
-            show_max_cpus_per_node = 1;
-            show_max_mem_per_cpu = 1;
-            show_def_mem_per_cpu = 1;
-            show_mjt_time = 1;
-            show_djt_time = 1;
-            show_partition_qos = 1;
             show_parameter_L = 1;
             show_all_partition = 1;
             break;
@@ -312,1115 +303,452 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  if (slurm_load_ctl_conf((time_t)NULL, &conf_info_msg_ptr)) {
-    slurm_perror("slurm_load_ctl_conf error");
+  /* the columns, which are not given, are not computed */
+  if ((given_format != NULL) &&
+      (!sp_headers_set_format(&spheaders, given_format))) {
+    sp_spart_usage();
     exit(1);
   }
 
-  if (slurm_load_jobs((time_t)NULL, &job_buffer_ptr, SHOW_ALL)) {
-    slurm_perror("slurm_load_jobs error");
+  if ((spbatch.dir != NULL) &&
+      ((show_json) || (metrics_file != NULL) || (watch_seconds))) {
+    printf("\nParameter --batch does not work with -j, --metrics, --watch!\n");
+    sp_spart_usage();
+    printf("\nParameter --batch does not work with -j, --metrics, --watch!\n");
     exit(1);
   }
 
-  if (slurm_load_node((time_t)NULL, &node_buffer_ptr, SHOW_ALL)) {
-    slurm_perror("slurm_load_node error");
+  if ((record_file != NULL) && (replay_file != NULL)) {
+    printf("\nParameters --record and --replay can not be used together!\n");
+    sp_spart_usage();
+    printf("\nParameters --record and --replay can not be used together!\n");
     exit(1);
   }
 
-  if (slurm_load_partitions((time_t)NULL, &part_buffer_ptr, show_partition)) {
-    slurm_perror("slurm_load_partitions error");
+  /* the slurm data and the user of the record are used */
+  if ((replay_file != NULL) &&
+      (!sp_record_read(&sprec, replay_file, &spuser))) {
+    fprintf(stderr, "Can not read the record file %s!\n", replay_file);
     exit(1);
   }
 
-#ifdef __slurmdb_cluster_rec_t_defined
-  sp_strn2cpy(cluster_name, SPART_MAX_COLUMN_SIZE,
-              conf_info_msg_ptr->cluster_name, SPART_MAX_COLUMN_SIZE);
-#endif
-
-  /* to check that can we read pending jobs info */
-  if (conf_info_msg_ptr->private_data != 0) {
-    printf("WARNING: The Slurm settings have info restrictions!\n");
+  /* the partitions, which are not given, are not computed */
+  if (show_given_partition) sp_names_set_build(&given_parts, given_part_list);
 
-    /* to check that can we read pending jobs info */
-    if (conf_info_msg_ptr->private_data & PRIVATE_DATA_JOBS) {
-      printf("\tthe spart can not show other users' waiting jobs info!\n");
-      if (show_parameter_L != 1) {
-        spheaders.waiting_resource.visible = 0;
-        spheaders.waiting_other.visible = 0;
-      }
-    }
-
-    if (conf_info_msg_ptr->private_data & PRIVATE_DATA_NODES) {
-      printf("\tthe spart can not show node status info!\n");
-    }
-
-    if (conf_info_msg_ptr->private_data & PRIVATE_DATA_PARTITIONS) {
-      printf("\tthe spart can not show partition info!\n");
-    }
-    printf("\n");
-  }
-
-#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
-    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
-    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
-/* Getting user account info */
-#if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
-  db_conn = slurmdb_connection_get(NULL);
-#else
-  db_conn = slurmdb_connection_get();
+#if defined(SPART_SERVER_SOCKET) || defined(SPART_CACHE_DIR)
+  /* The watch mode asks the slurmctld, to see the changes at once. The
+   * batch mode needs the job counts of all users, and the record and the
+   * replay need the slurm data itself. */
+  use_cache = (!watch_seconds) && (spbatch.dir == NULL) &&
+              (record_file == NULL) && (replay_file == NULL);
 #endif
-  if (errno != SLURM_SUCCESS) {
-    slurm_perror("Can not connect to the slurm database");
-    exit(1);
-  }
-
-  memset(&assoc_cond, 0, sizeof(slurmdb_assoc_cond_t));
-  assoc_cond.user_list = slurm_list_create(NULL);
-  slurm_list_append(assoc_cond.user_list, user_name);
-  assoc_cond.acct_list = slurm_list_create(NULL);
-
-  assoc_list = slurmdb_associations_get(db_conn, &assoc_cond);
-  itr = slurm_list_iterator_create(assoc_list);
 
-  user_acct_count = slurm_list_count(assoc_list);
-  user_acct = malloc(user_acct_count * sizeof(char *));
-  user_qos_count = 0;
-
-  for (k = 0; k < user_acct_count; k++) {
-    assoc = slurm_list_next(itr);
-    qos_list = assoc->qos_list;
-    user_qos_count += slurm_list_count(qos_list);
-  }
-
-  user_qos = malloc(user_qos_count * sizeof(char *));
-
-  qosn_list = slurmdb_qos_get(db_conn, NULL);
-  itr_qosn = slurm_list_iterator_create(qosn_list);
+#ifdef SPART_SERVER_SOCKET
+  if (use_cache)
+    from_cache = sp_server_query(SPART_SERVER_SOCKET, show_partition | SHOW_ALL,
+                                 &spsnap);
+#endif
 
-  n = 0;
-  slurm_list_iterator_reset(itr);
-  for (k = 0; k < user_acct_count; k++) {
-    user_acct[k] = malloc(SPART_INFO_STRING_SIZE * sizeof(char));
-    assoc = slurm_list_next(itr);
-    sp_strn2cpy(user_acct[k], SPART_INFO_STRING_SIZE, assoc->acct,
-                SPART_INFO_STRING_SIZE);
+#ifdef SPART_CACHE_DIR
+  /* All partitions are saved to the snapshot, so it can be shared by
+   * the spart calls with and without -a parameter */
+  snprintf(cache_path, SPART_INFO_STRING_SIZE, "%s%s%d", SPART_CACHE_DIR,
+           SPART_CACHE_FILE, (int)(show_partition | SHOW_ALL));
+  if ((!from_cache) && (use_cache))
+    from_cache = sp_cache_read(cache_path, &spsnap);
+  /* only the owner of the cache directory refreshes the snapshot, the
+   * others ask the slurmctld without waiting */
+  if ((!from_cache) && (use_cache) && (getuid() == sp_cache_owner()))
+    cache_write = 1;
+#endif
 
-    qos_list = assoc->qos_list;
-    user_qos_count = slurm_list_count(qos_list);
-    if (user_qos_count > 0) {
-      itr_qos = slurm_list_iterator_create(qos_list);
-      for (m = 0; m < user_qos_count; m++) {
-        user_qos[n] = malloc(SPART_INFO_STRING_SIZE * sizeof(char));
-        qos = slurm_list_next(itr_qos);
-        //qos2 = (char *)slurmdb_qos_str(qosn_list, atoi(qos));
-        sp_strn2cpy(user_qos[n], SPART_INFO_STRING_SIZE, qos,
-                    SPART_INFO_STRING_SIZE);
-        n++;
+  /* Only the slurm data, which is needed by the visible columns, is loaded
+   * and computed. The snapshot and the record are shared, so they contain
+   * all columns. The user info is read later, only if the partitions need
+   * it. */
+  sp_plan_make(&spplan, &spheaders);
+  if ((cache_write) || (record_file != NULL)) {
+    spplan.compute = SPART_PLAN_ALL;
+    sp_plan_set_wanted(&spplan);
+  }
+  if (metrics_file != NULL) {
+    spplan.compute |= SPART_PLAN_METRICS;
+    sp_plan_set_wanted(&spplan);
+  }
+  if ((spbatch.dir != NULL) && (strcmp(spbatch.list, "all") == 0)) {
+    /* the users of the batch are found from the jobs */
+    spplan.compute |= SPART_PLAN_MY_JOBS;
+    sp_plan_set_wanted(&spplan);
+  }
+  sp_lib_init(&splib, &spuser, show_partition, &spplan);
+  /* the user wants to see the current accounts and QOSs */
+  splib.fetch.assoc_refresh = show_info;
+#ifdef SPART_CACHE_DIR
+  splib.fetch.show_partition |= SHOW_ALL;
+#endif
+  /* The batch needs all partitions, to list them for each user as the
+   * slurm lists them. The record is replayed with or without -a. */
+  if ((record_file != NULL) || (spbatch.dir != NULL))
+    splib.fetch.show_partition |= SHOW_ALL;
+  if (replay_file != NULL) sp_lib_use_record(&splib, &sprec);
+  /* the snapshot contains all partitions, and the job counts of all users */
+  if ((show_given_partition) && (!cache_write)) splib.given = &given_parts;
+  if ((cache_write) || (spbatch.dir != NULL)) splib.user_jobs = &user_jobs;
+  hidden_loaded =
+      from_cache || (splib.fetch.show_partition != show_partition);
+
+  /* All output is collected in spout, and written at once at the end */
+  sp_strbuf_init(&spout);
+
+  /* the values, which are changed by the data of each refresh */
+  spheaders_opt = spheaders;
+  show_all_opt = show_all_partition;
+  if (watch_seconds) sp_watch_init(&spwatch, watch_seconds);
+
+  /* The watch mode refreshes the output until it is killed. The slurm
+   * sends only the changed data, and the node values are computed again
+   * only if the nodes or the partitions are changed. The batch mode makes
+   * the output of a user at each round, from the same data. */
+  for (;;) {
+    if ((rounds > 0) && (watch_seconds)) sp_watch_wait(&spwatch);
+    if ((!from_cache) && ((rounds == 0) || (spbatch.dir == NULL)) &&
+        (!sp_lib_fetch(&splib))) {
+      if (rounds == 0) sp_fetch_check(&(splib.fetch));
+      /* the last output is shown, until the slurmctld answers again */
+      if (splib.failed >= 0)
+        snprintf(note, SPART_INFO_STRING_SIZE, "%s: %s",
+                 sp_fetch_error_info[splib.failed],
+                 slurm_strerror(splib.fetch.request[splib.failed].error));
+      if ((show_json) || (metrics_file != NULL)) {
+        if (splib.failed >= 0) fprintf(stderr, "%s\n", note);
+      } else {
+        /* if the data is not changed, only the time is changed */
+        sp_watch_show(&spwatch, NULL, (splib.failed >= 0) ? note : NULL);
       }
+      continue;
     }
-  }
-
-  slurm_list_iterator_destroy(itr);
-  if (user_qos_count > 0) slurm_list_iterator_destroy(itr_qos);
-  // slurm_list_destroy(qos_list);
-  slurm_list_destroy(assoc_list);
-  slurm_list_iterator_destroy(itr_qosn);
-  slurm_list_destroy(qosn_list);
-#else
-  snprintf(sh_str, SPART_INFO_STRING_SIZE,
-           "sacctmgr list association format=account%%-30 where user=%s -n "
-           "2>/dev/null |tr -s '\n, ' ' '",
-           user_name);
-  fo = popen(sh_str, "r");
-  if (fo) {
-    fgets(re_str, SPART_INFO_STRING_SIZE, fo);
-    if (re_str[0] == '\0')
-      user_acct_count = 1;
-    else
-      user_acct_count = 0;
-    k = 0;
-    for (j = 0; re_str[j]; j++)
-      if (re_str[j] == ' ') user_acct_count++;
-
-    user_acct = malloc(user_acct_count * sizeof(char *));
-    for (p_str = strtok_r(re_str, " ", &t_str); p_str != NULL;
-         p_str = strtok_r(NULL, " ", &t_str)) {
-      user_acct[k] = malloc(SPART_INFO_STRING_SIZE * sizeof(char));
-      sp_strn2cpy(user_acct[k], SPART_INFO_STRING_SIZE, p_str,
-                  SPART_INFO_STRING_SIZE);
-      k++;
-    }
-  }
-  pclose(fo);
-
-  snprintf(sh_str, SPART_INFO_STRING_SIZE,
-           "sacctmgr list association format=qos%%-30 where user=%s -n "
-           "2>/dev/null |tr -s '\n, ' ' '",
-           user_name);
-  fo = popen(sh_str, "r");
-  if (fo) {
-    fgets(re_str, SPART_INFO_STRING_SIZE, fo);
-    if (re_str[0] == '\0')
-      user_qos_count = 1;
-    else
-      user_qos_count = 0;
-    k = 0;
-    for (j = 0; re_str[j]; j++)
-      if (re_str[j] == ' ') user_qos_count++;
-
-    user_qos = malloc(user_qos_count * sizeof(char *));
-    for (p_str = strtok_r(re_str, " ", &t_str); p_str != NULL;
-         p_str = strtok_r(NULL, " ", &t_str)) {
-      user_qos[k] = malloc(SPART_INFO_STRING_SIZE * sizeof(char));
-      sp_strn2cpy(user_qos[k], SPART_INFO_STRING_SIZE, p_str,
-                  SPART_INFO_STRING_SIZE);
-      k++;
-    }
-  }
-  pclose(fo);
 
+    if (rounds > 0) {
+      /* the values of the last refresh */
+      spheaders = spheaders_opt;
+      show_all_partition = show_all_opt;
+      limits_set = 0;
+      partname_lenght = 0;
+#ifdef __slurmdb_cluster_rec_t_defined
+      clusname_lenght = 0;
 #endif
+      legends[0] = 0;
+      first = 0;
+    }
 
-  if (show_info) {
-    sp_print_user_info(user_name, user_group, user_group_count, user_acct,
-                       user_acct_count, user_qos, user_qos_count);
-  }
-
-  /* Initialize spart data for each partition */
-  partition_count = part_buffer_ptr->record_count;
-  spData = (sp_part_info_t *)malloc(partition_count * sizeof(sp_part_info_t));
-
-  for (i = 0; i < partition_count; i++) {
-    spData[i].free_cpu = 0;
-    spData[i].total_cpu = 0;
-    spData[i].free_node = 0;
-    spData[i].total_node = 0;
-    spData[i].waiting_resource = 0;
-    spData[i].waiting_other = 0;
-    spData[i].min_nodes = 0;
-    spData[i].max_nodes = 0;
-    spData[i].max_cpus_per_node = 0;
-    spData[i].max_mem_per_cpu = 0;
-    /* MaxJobTime */
-    spData[i].mjt_time = 0;
-    /* DefaultJobTime */
-    spData[i].djt_time = 0;
-#ifdef SPART_SHOW_STATEMENT
-    spData[i].show_statement = show_info;
+    if (from_cache) {
+#ifdef SPART_USE_SNAPSHOT
+      sp_lib_use_snapshot(&splib, &spsnap);
 #endif
-    spData[i].min_core = 0;
-    spData[i].max_core = 0;
-    spData[i].min_mem_gb = 0;
-    spData[i].max_mem_gb = 0;
-    spData[i].my_waiting_resource = 0;
-    spData[i].my_waiting_other = 0;
-    spData[i].my_running = 0;
-    spData[i].my_total = 0;
-    spData[i].visible = 1;
-/* partition_name[] */
+    } else if ((rounds == 0) || (spbatch.dir == NULL)) {
+      sp_lib_compute(&splib);
+#ifdef SPART_CACHE_DIR
+      if ((cache_write) && (splib.private_data == 0))
+        sp_cache_write(cache_path, time(NULL), splib.private_data,
 #ifdef __slurmdb_cluster_rec_t_defined
-    spData[i].cluster_name[0] = 0;
+                       splib.cluster_name,
+#else
+                       NULL,
 #endif
-    spData[i].partition_name[0] = 0;
-    spData[i].partition_qos[0] = 0;
-    spData[i].partition_status[0] = 0;
-  }
-
-  /* Finds resource/other waiting core count for each partition */
-  for (i = 0; i < job_buffer_ptr->record_count; i++) {
-    /* add ',' character at the begining and the end */
-    sp_strn2cpy(job_parts_str, SPART_INFO_STRING_SIZE, ",",
-                SPART_INFO_STRING_SIZE);
-    sp_strn2cat(job_parts_str, SPART_INFO_STRING_SIZE,
-                job_buffer_ptr->job_array[i].partition, SPART_INFO_STRING_SIZE);
-    sp_strn2cat(job_parts_str, SPART_INFO_STRING_SIZE, ",", 2);
-
-    for (j = 0; j < partition_count; j++) {
-      /* add ',' character at the begining and the end */
-      sp_strn2cpy(partition_str, SPART_INFO_STRING_SIZE, ",",
-                  SPART_INFO_STRING_SIZE);
-      sp_strn2cat(partition_str, SPART_INFO_STRING_SIZE,
-                  part_buffer_ptr->partition_array[j].name,
-                  SPART_INFO_STRING_SIZE);
-      sp_strn2cat(partition_str + strlen(partition_str), SPART_INFO_STRING_SIZE,
-                  ",", 2);
-
-      if (strstr(job_parts_str, partition_str) != NULL) {
-        if (job_buffer_ptr->job_array[i].job_state == JOB_PENDING) {
-          if ((job_buffer_ptr->job_array[i].state_reason == WAIT_RESOURCES) ||
-              (job_buffer_ptr->job_array[i].state_reason ==
-               WAIT_NODE_NOT_AVAIL) ||
-              (job_buffer_ptr->job_array[i].state_reason == WAIT_PRIORITY)) {
-            spData[j].waiting_resource += job_buffer_ptr->job_array[i].num_cpus;
-            if (job_buffer_ptr->job_array[i].user_id == user_id)
-              spData[j].my_waiting_resource++;
-          } else {
-            spData[j].waiting_other += job_buffer_ptr->job_array[i].num_cpus;
-            if (job_buffer_ptr->job_array[i].user_id == user_id)
-              spData[j].my_waiting_other++;
-          }
-        } else {
-          if ((job_buffer_ptr->job_array[i].user_id == user_id) &&
-              (job_buffer_ptr->job_array[i].job_state == JOB_RUNNING))
-            spData[j].my_running++;
+                       splib.parts, splib.part_count, splib.strs, &user_jobs);
+#endif
+      if ((record_file != NULL) && (rounds == 0)) {
+        /* the record has all user info, so it can be replayed with -i */
+        if (sp_lib_identity(&splib, 1) >= 0) sp_fetch_check(&(splib.fetch));
+        if (!sp_record_write(record_file, &(splib.fetch))) {
+          fprintf(stderr, "Can not write the record file %s: %s\n",
+                  record_file, strerror(errno));
+          exit(1);
         }
-        if ((job_buffer_ptr->job_array[i].user_id == user_id) &&
-            ((job_buffer_ptr->job_array[i].job_state == JOB_PENDING) ||
-             (job_buffer_ptr->job_array[i].job_state == JOB_RUNNING) ||
-             (job_buffer_ptr->job_array[i].job_state == JOB_SUSPENDED)))
-          spData[j].my_total++;
       }
     }
-  }
-
-  show_gres = spheaders.gres.visible;
-  show_features = spheaders.features.visible;
-  for (i = 0; i < partition_count; i++) {
-    part_ptr = &part_buffer_ptr->partition_array[i];
-
-    min_mem = UINT_MAX;
-    max_mem = 0;
-    min_cpu = UINT_MAX;
-    max_cpu = 0;
-    free_cpu = 0;
-    free_node = 0;
-    alloc_cpus = 0;
-    max_mem_per_cpu = 0;
-    def_mem_per_cpu = 0;
+    private_data = splib.private_data;
+    spData = splib.parts;
+    partition_count = splib.part_count;
+    strs = splib.strs;
 
-    sp_gres_reset_counts(spgres, &sp_gres_count);
-    sp_gres_reset_counts(spfeatures, &sp_features_count);
-
-    for (j = 0; part_ptr->node_inx; j += 2) {
-      if (part_ptr->node_inx[j] == -1) break;
-      for (k = part_ptr->node_inx[j]; k <= part_ptr->node_inx[j + 1]; k++) {
-        cpus = node_buffer_ptr->node_array[k].cpus;
-        mem = (uint32_t)(node_buffer_ptr->node_array[k].real_memory);
-        if (min_mem > mem) min_mem = mem;
-        if (max_mem < mem) max_mem = mem;
-        if (min_cpu > cpus) min_cpu = cpus;
-        if (max_cpu < cpus) max_cpu = cpus;
-
-        slurm_get_select_nodeinfo(
-            node_buffer_ptr->node_array[k].select_nodeinfo,
-            SELECT_NODEDATA_SUBCNT, NODE_STATE_ALLOCATED, &alloc_cpus);
-
-        state = node_buffer_ptr->node_array[k].node_state;
-        /* If gres will not show, don't run */
-        if ((show_gres) && (node_buffer_ptr->node_array[k].gres != NULL)) {
-          sp_gres_add(spgres, &sp_gres_count,
-                      node_buffer_ptr->node_array[k].gres);
+    if (spbatch.dir != NULL) {
+      if (rounds == 0) {
+        /* the jobs of the other users are not counted */
+        if (private_data != 0) {
+          fprintf(stderr,
+                  "Parameter --batch does not work, if the Slurm settings "
+                  "have info restrictions!\n");
+          exit(1);
         }
-
-        /* If features will not show, don't run */
-        if (show_features) {
-          if (node_buffer_ptr->node_array[k].features_act != NULL)
-            sp_gres_add(spfeatures, &sp_features_count,
-                        node_buffer_ptr->node_array[k].features_act);
-          else if (node_buffer_ptr->node_array[k].features != NULL)
-            sp_gres_add(spfeatures, &sp_features_count,
-                        node_buffer_ptr->node_array[k].features);
+        k = sp_batch_load(&spbatch, &splib, show_info);
+        if (k != 0) {
+          fprintf(stderr, "%s: %s\n", sp_fetch_error_info[SPART_FETCH_ASSOC],
+                  slurm_strerror(k));
+          exit(1);
         }
-#ifdef SPART_COMPILE_FOR_UHEM
-        reason = node_buffer_ptr->node_array[k].reason;
-#endif
-
-        /* The PowerSave_PwrOffState and PwrON_State_PowerSave control
-         * for an alternative power saving solution we developed.
-         * It required for showing power-off nodes as idle */
-        if ((((state & NODE_STATE_DRAIN) != NODE_STATE_DRAIN) &&
-             ((state & NODE_STATE_BASE) != NODE_STATE_DOWN) &&
-             (state != NODE_STATE_UNKNOWN))
-#ifdef SPART_COMPILE_FOR_UHEM
-            ||
-            (strncmp(reason, "PowerSave_PwrOffState", 21) == 0) ||
-            (strncmp(reason, "PwrON_State_PowerSave", 21) == 0)
-#endif
-            ) {
-          if (alloc_cpus == 0) free_node += 1;
-          free_cpu += cpus - alloc_cpus;
+        if (spbatch.count == 0) {
+          fprintf(stderr, "There is no user for the batch!\n");
+          exit(1);
         }
       }
+      if (sp_batch_select(&spbatch, &splib, rounds) != 0)
+        fprintf(stderr, "Can not read the groups of %s!\n",
+                splib.fetch.user->user_name);
     }
 
-#ifdef __slurmdb_cluster_rec_t_defined
-    if (part_ptr->cluster_name != NULL) {
-      sp_strn2cpy(spData[i].cluster_name, SPART_MAX_COLUMN_SIZE,
-                  part_ptr->cluster_name, SPART_MAX_COLUMN_SIZE);
-      tmp_lenght = strlen(part_ptr->cluster_name);
-      if (tmp_lenght > clusname_lenght) clusname_lenght = tmp_lenght;
-    } else {
-      sp_strn2cpy(spData[i].cluster_name, SPART_MAX_COLUMN_SIZE, cluster_name,
-                  SPART_MAX_COLUMN_SIZE);
-      tmp_lenght = strlen(cluster_name);
-      if (tmp_lenght > clusname_lenght) clusname_lenght = tmp_lenght;
-    }
-#endif
-
-    /* Partition States from more important to less important
-     *  because, there is limited space. */
-    if (part_ptr->flags & PART_FLAG_DEFAULT)
-      sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "*", 2);
-    if (part_ptr->flags & PART_FLAG_HIDDEN)
-      sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, ".", 2);
-
-#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
-    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
-    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
-
-    k = sp_check_permision_set_legend(
-        part_ptr->allow_accounts, user_acct, user_acct_count,
-        spData[i].partition_status, NULL, "a", "A");
-    if ((!show_all_partition) && (k == 0)) spData[i].visible = 0;
-
-    k = sp_check_permision_set_legend(
-        part_ptr->deny_accounts, user_acct, user_acct_count,
-        spData[i].partition_status, "A", "a", NULL);
-    if ((!show_all_partition) && (k == 0)) spData[i].visible = 0;
-
-    k = sp_check_permision_set_legend(
-        part_ptr->allow_qos, user_qos, user_qos_count,
-        spData[i].partition_status, NULL, "q", "Q");
-    if ((!show_all_partition) && (k == 0)) spData[i].visible = 0;
-
-    k = sp_check_permision_set_legend(
-        part_ptr->deny_qos, user_qos, user_qos_count,
-        spData[i].partition_status, "Q", "q", NULL);
-    if ((!show_all_partition) && (k == 0)) spData[i].visible = 0;
-
-    k = sp_check_permision_set_legend(
-        part_ptr->allow_groups, user_group, user_group_count,
-        spData[i].partition_status, NULL, "g", "G");
-    if ((!show_all_partition) && (k == 0)) spData[i].visible = 0;
-
-#endif
-
-    if (strncmp(user_name, "root", SPART_INFO_STRING_SIZE) == 0) {
-      if (part_ptr->flags & PART_FLAG_NO_ROOT) {
-        sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "R", 2);
-        if (!show_all_partition) spData[i].visible = 0;
-      }
-    } else {
-      if (part_ptr->flags & PART_FLAG_ROOT_ONLY) {
-        sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "R", 2);
-        if (!show_all_partition) spData[i].visible = 0;
+    /* The accounts, QOSs and groups of the user are read only if an access
+     * list of a partition contains them. They are not changed while
+     * watching. */
+    if (sp_lib_identity(&splib, show_info) >= 0)
+      sp_fetch_check(&(splib.fetch));
+    /* to check that can we read pending jobs info */
+    if (private_data != 0) {
+      sp_strbuf_cat(&spout,
+                    "WARNING: The Slurm settings have info restrictions!\n");
+
+      /* to check that can we read pending jobs info */
+      if (private_data & PRIVATE_DATA_JOBS) {
+        sp_strbuf_cat(
+            &spout,
+            "\tthe spart can not show other users' waiting jobs info!\n");
+        if (show_parameter_L != 1) {
+          spheaders.col[SPART_COL_RESOURCE_PENDING].visible = 0;
+          spheaders.col[SPART_COL_OTHER_PENDING].visible = 0;
+        }
       }
-    }
-
-    if (!(part_ptr->state_up == PARTITION_UP)) {
-      if (part_ptr->state_up == PARTITION_INACTIVE)
-        sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "C", 2);
-      if (part_ptr->state_up == PARTITION_DRAIN)
-        sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "S", 2);
-      if (part_ptr->state_up == PARTITION_DOWN)
-        sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "D", 2);
-    }
-
-    if (part_ptr->flags & PART_FLAG_REQ_RESV)
-      sp_strn2cat(spData[i].partition_status, SPART_MAX_COLUMN_SIZE, "r", 2);
 
-    /* if (part_ptr->flags & PART_FLAG_EXCLUSIVE_USER)
-      strncat(spData[i].partition_status, "x", SPART_MAX_COLUMN_SIZE);*/
-
-    /* spgres (GRES) data converting to string */
-    if (sp_gres_count == 0) {
-      sp_strn2cpy(spData[i].gres, SPART_INFO_STRING_SIZE, "-",
-                  SPART_INFO_STRING_SIZE);
-    } else {
-      sp_con_strprint(strtmp, SPART_INFO_STRING_SIZE, spgres[0].count);
-      snprintf(mem_result, SPART_INFO_STRING_SIZE, "%s(%s)",
-               spgres[0].gres_name, strtmp);
-      sp_strn2cpy(spData[i].gres, SPART_INFO_STRING_SIZE, mem_result,
-                  SPART_INFO_STRING_SIZE);
-      for (j = 1; j < sp_gres_count; j++) {
-        sp_con_strprint(strtmp, SPART_INFO_STRING_SIZE, spgres[j].count);
-        snprintf(mem_result, SPART_INFO_STRING_SIZE, ",%s(%s)",
-                 spgres[j].gres_name, strtmp);
-        sp_strn2cat(spData[i].gres, SPART_INFO_STRING_SIZE, mem_result,
-                    SPART_INFO_STRING_SIZE);
+      if (private_data & PRIVATE_DATA_NODES) {
+        sp_strbuf_cat(&spout, "\tthe spart can not show node status info!\n");
       }
-    }
 
-    /* spfeatures data converting to string */
-    if (sp_features_count == 0) {
-      sp_strn2cpy(spData[i].features, SPART_INFO_STRING_SIZE, "-",
-                  SPART_INFO_STRING_SIZE);
-    } else {
-      sp_con_strprint(strtmp, SPART_INFO_STRING_SIZE, spfeatures[0].count);
-      snprintf(mem_result, SPART_INFO_STRING_SIZE, "%s(%s)",
-               spfeatures[0].gres_name, strtmp);
-      sp_strn2cpy(spData[i].features, SPART_INFO_STRING_SIZE, mem_result,
-                  SPART_INFO_STRING_SIZE);
-      for (j = 1; j < sp_features_count; j++) {
-        sp_con_strprint(strtmp, SPART_INFO_STRING_SIZE, spfeatures[j].count);
-        snprintf(mem_result, SPART_INFO_STRING_SIZE, ",%s(%s)",
-                 spfeatures[j].gres_name, strtmp);
-        sp_strn2cat(spData[i].features, SPART_INFO_STRING_SIZE, mem_result,
-                    SPART_INFO_STRING_SIZE);
+      if (private_data & PRIVATE_DATA_PARTITIONS) {
+        sp_strbuf_cat(&spout, "\tthe spart can not show partition info!\n");
       }
+      sp_strbuf_catn(&spout, "\n", 1);
     }
-    spData[i].free_cpu = free_cpu;
-    spData[i].total_cpu = part_ptr->total_cpus;
-    spData[i].free_node = free_node;
-    spData[i].total_node = part_ptr->total_nodes;
-
-    if (!show_simple) {
-      spData[i].min_nodes = part_ptr->min_nodes;
-      if ((part_ptr->min_nodes != default_min_nodes) && (spData[i].visible))
-        show_min_nodes = 1;
-      spData[i].max_nodes = part_ptr->max_nodes;
-      if ((part_ptr->max_nodes != default_max_nodes) && (spData[i].visible))
-        show_max_nodes = 1;
-      spData[i].max_cpus_per_node = part_ptr->max_cpus_per_node;
-      if ((part_ptr->max_cpus_per_node != default_max_cpus_per_node) &&
-          (part_ptr->max_cpus_per_node != 0) && (spData[i].visible))
-        show_max_cpus_per_node = 1;
-
-      /* the def_mem_per_cpu and max_mem_per_cpu members contains
-       * both FLAG bit (MEM_PER_CPU) for CPU/NODE selection, and values. */
-      def_mem_per_cpu = part_ptr->def_mem_per_cpu;
-      if (def_mem_per_cpu & MEM_PER_CPU) {
-        sp_strn2cpy(spheaders.def_mem_per_cpu.line2,
-                    spheaders.def_mem_per_cpu.column_width + 1, "GB/CPU",
-                    spheaders.def_mem_per_cpu.column_width + 1);
-        def_mem_per_cpu = def_mem_per_cpu & (~MEM_PER_CPU);
-      } else {
-        sp_strn2cpy(spheaders.def_mem_per_cpu.line2,
-                    spheaders.def_mem_per_cpu.column_width + 1, "G/NODE",
-                    spheaders.def_mem_per_cpu.column_width + 1);
-      }
-      spData[i].def_mem_per_cpu = (uint64_t)(def_mem_per_cpu / 1000u);
-      if ((def_mem_per_cpu != default_def_mem_per_cpu) && (spData[i].visible))
-        show_def_mem_per_cpu = 1;
-
-      max_mem_per_cpu = part_ptr->max_mem_per_cpu;
-      if (max_mem_per_cpu & MEM_PER_CPU) {
-        sp_strn2cpy(spheaders.max_mem_per_cpu.line2,
-                    spheaders.max_mem_per_cpu.column_width + 1, "GB/CPU",
-                    spheaders.max_mem_per_cpu.column_width + 1);
-        max_mem_per_cpu = max_mem_per_cpu & (~MEM_PER_CPU);
-      } else {
-        sp_strn2cpy(spheaders.max_mem_per_cpu.line2,
-                    spheaders.max_mem_per_cpu.column_width + 1, "G/NODE",
-                    spheaders.max_mem_per_cpu.column_width + 1);
-      }
-      spData[i].max_mem_per_cpu = (uint64_t)(max_mem_per_cpu / 1000u);
-      if ((max_mem_per_cpu != default_max_mem_per_cpu) && (spData[i].visible))
-        show_max_mem_per_cpu = 1;
-
-      spData[i].mjt_time = part_ptr->max_time;
-      if ((part_ptr->max_time != default_mjt_time) && (spData[i].visible))
-        show_mjt_time = 1;
-      spData[i].djt_time = part_ptr->default_time;
-      if ((part_ptr->default_time != default_mjt_time) &&
-          (part_ptr->default_time != NO_VAL) &&
-          (part_ptr->default_time != part_ptr->max_time) && (spData[i].visible))
-        show_djt_time = 1;
-      spData[i].min_core = min_cpu;
-      spData[i].max_core = max_cpu;
-      spData[i].max_mem_gb = (uint16_t)(max_mem / 1000u);
-      spData[i].min_mem_gb = (uint16_t)(min_mem / 1000u);
 
-      if ((part_ptr->qos_char != NULL) && (strlen(part_ptr->qos_char) > 0)) {
-        sp_strn2cpy(spData[i].partition_qos, SPART_MAX_COLUMN_SIZE,
-                    part_ptr->qos_char, SPART_MAX_COLUMN_SIZE);
-        if (strncmp(part_ptr->qos_char, default_qos, SPART_MAX_COLUMN_SIZE) !=
-            0)
-          show_partition_qos = 1;
-      } else
-        sp_strn2cpy(spData[i].partition_qos, SPART_MAX_COLUMN_SIZE, "-",
-                    SPART_MAX_COLUMN_SIZE);
+    if (show_info) {
+      sp_print_user_info(&spout, splib.fetch.user->user_name,
+                         splib.fetch.user->user_group,
+                         splib.fetch.user->user_group_count,
+                         splib.fetch.user->user_acct,
+                         splib.fetch.user->user_acct_count,
+                         splib.fetch.user->user_qos,
+                         splib.fetch.user->user_qos_count);
     }
-    sp_strn2cpy(spData[i].partition_name, SPART_MAX_COLUMN_SIZE, part_ptr->name,
-                SPART_MAX_COLUMN_SIZE);
-    tmp_lenght = strlen(part_ptr->name);
-    if (tmp_lenght > partname_lenght) partname_lenght = tmp_lenght;
-  }
-
-  if (show_given_partition == 1) {
-    char *strtmp = NULL;
-    char *grestok;
-    char pl[SPART_INFO_STRING_SIZE];
 
+    /* The user dependent values of each partition. The snapshot contains
+     * the partitions that the slurm hides. */
+    sp_lib_evaluate(&splib, show_all_partition,
+                    (hidden_loaded) && !(show_partition & SHOW_ALL));
     for (i = 0; i < partition_count; i++) {
-      part_ptr = &part_buffer_ptr->partition_array[i];
-      sp_strn2cpy(pl, SPART_INFO_STRING_SIZE, given_part_list,
-                  SPART_INFO_STRING_SIZE);
-      for (grestok = strtok_r(pl, ",", &strtmp); grestok != NULL;
-           grestok = strtok_r(NULL, ",", &strtmp)) {
-        if (strncmp(part_ptr->name, grestok, SPART_INFO_STRING_SIZE) == 0) {
-          spData[i].visible = 1;
-          break;
-        } else {
-          spData[i].visible = 0;
-        }
-      }
-    }
-    show_all_partition = 0;
-  }
-
-  if (partname_lenght > spheaders.partition_name.column_width) {
-    m = partname_lenght - spheaders.partition_name.column_width;
-
-    sp_strn2cpy(strtmp, SPART_INFO_STRING_SIZE, spheaders.partition_name.line1,
-                SPART_INFO_STRING_SIZE);
-    strcpy(spheaders.partition_name.line1, " ");
-    for (k = 1; k < m; k++)
-      sp_strn2cat(spheaders.partition_name.line1, partname_lenght, " ", 2);
-    sp_strn2cat(spheaders.partition_name.line1, partname_lenght, strtmp,
-                partname_lenght);
-
-    sp_strn2cpy(strtmp, SPART_INFO_STRING_SIZE, spheaders.partition_name.line2,
-                SPART_INFO_STRING_SIZE);
-    strcpy(spheaders.partition_name.line2, " ");
-    for (k = 1; k < m; k++)
-      sp_strn2cat(spheaders.partition_name.line2, partname_lenght, " ", 2);
-    sp_strn2cat(spheaders.partition_name.line2, partname_lenght, strtmp,
-                partname_lenght);
-
-    spheaders.partition_name.column_width = partname_lenght;
-  }
-
-#ifdef __slurmdb_cluster_rec_t_defined
-  if (clusname_lenght > spheaders.cluster_name.column_width) {
-    m = clusname_lenght - spheaders.cluster_name.column_width;
-
-    sp_strn2cpy(strtmp, SPART_INFO_STRING_SIZE, spheaders.cluster_name.line1,
-                SPART_INFO_STRING_SIZE);
-    strcpy(spheaders.cluster_name.line1, " ");
-    for (k = 1; k < m; k++)
-      sp_strn2cat(spheaders.cluster_name.line1, clusname_lenght, " ", 2);
-    sp_strn2cat(spheaders.cluster_name.line1, clusname_lenght, strtmp,
-                clusname_lenght);
-
-    sp_strn2cpy(strtmp, SPART_INFO_STRING_SIZE, spheaders.cluster_name.line2,
-                SPART_INFO_STRING_SIZE);
-    strcpy(spheaders.cluster_name.line2, " ");
-    for (k = 1; k < m; k++)
-      sp_strn2cat(spheaders.cluster_name.line2, clusname_lenght, " ", 2);
-    sp_strn2cat(spheaders.cluster_name.line2, clusname_lenght, strtmp,
-                clusname_lenght);
-
-    spheaders.cluster_name.column_width = clusname_lenght;
-  }
+      if (!(splib.listed[i])) continue;
+#ifdef SPART_SHOW_STATEMENT
+      spData[i].show_statement = show_info;
 #endif
 
-  /* If these column at default values, don't show */
-  if ((!show_parameter_L) && (!show_simple)) {
-    spheaders.min_nodes.visible = show_min_nodes;
-    spheaders.max_nodes.visible = show_max_nodes;
-    spheaders.max_cpus_per_node.visible = show_max_cpus_per_node;
-    spheaders.max_mem_per_cpu.visible = show_max_mem_per_cpu;
-    spheaders.def_mem_per_cpu.visible = show_def_mem_per_cpu;
-    spheaders.mjt_time.visible = show_mjt_time;
-    spheaders.djt_time.visible = show_djt_time;
-    spheaders.partition_qos.visible = show_partition_qos;
-  }
-  spheaders.my_running.visible = show_my_running;
-  spheaders.my_waiting_resource.visible = show_my_waiting_resource;
-  spheaders.my_waiting_other.visible = show_my_waiting_other;
-  spheaders.my_total.visible = show_my_total;
-
-  if (show_all_partition) {
-    for (i = 0; i < partition_count; i++) {
-      spData[i].visible = 1;
-    }
-  }
+      if (!show_simple) {
+        if (spData[i].visible) limits_set |= spData[i].set_limits;
+        /* the QOS is shown, even if only a hidden partition has it */
+        limits_set |= (spData[i].set_limits & SPART_SET_PARTITION_QOS);
 
-  /* Output width calculation */
-  total_width = 7; /* for || and space charecters */
-  total_width += spheaders.partition_name.column_width;
-  total_width += spheaders.partition_status.column_width;
-  total_width += spheaders.free_cpu.column_width;
-  total_width += spheaders.total_cpu.column_width;
-  total_width += spheaders.free_node.column_width;
-  total_width += spheaders.total_node.column_width;
-  total_width += spheaders.waiting_resource.column_width;
-  total_width += spheaders.waiting_other.column_width;
-
-  /* Common Values scanning */
-  /* reuse local show_xxx variables for different purpose */
-  show_all_partition = 0; /* are there common feature */
-  if (show_simple) {
-    total_width += spheaders.my_running.column_width +
-                   spheaders.my_waiting_resource.column_width +
-                   spheaders.my_waiting_other.column_width +
-                   spheaders.my_total.column_width + 4;
-  } else {
-    k = -1; /* first visible row (partition) */
-    for (i = 0; i < partition_count; i++)
-      if ((spData[i].visible) && (k == -1)) {
-        k = i; /* first visible partition */
+        if (spData[i].set_limits & SPART_DEF_MEM_IS_PER_CPU)
+          spheaders.col[SPART_COL_DEF_MEM].line2 = "GB/CPU";
+        else
+          spheaders.col[SPART_COL_DEF_MEM].line2 = "G/NODE";
+        if (spData[i].set_limits & SPART_MAX_MEM_IS_PER_CPU)
+          spheaders.col[SPART_COL_MAX_MEM].line2 = "GB/CPU";
+        else
+          spheaders.col[SPART_COL_MAX_MEM].line2 = "G/NODE";
       }
 
-    if (spheaders.my_running.visible) {/* is column visible */
-      show_my_running = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].my_running != spData[k].my_running) {
-            show_my_running = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-    }
-
-    if (spheaders.my_waiting_resource.visible) {/* is column visible */
-      show_my_waiting_resource = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].my_waiting_resource != spData[k].my_waiting_resource) {
-            show_my_waiting_resource = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-    }
-
-    if (spheaders.my_waiting_other.visible) {/* is column visible */
-      show_my_waiting_other = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].my_waiting_other != spData[k].my_waiting_other) {
-            show_my_waiting_other = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-    }
-
-    if (spheaders.my_total.visible) {/* is column visible */
-      show_my_total = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].my_total != spData[k].my_total) {
-            show_my_total = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_my_waiting_resource && show_my_waiting_other &&
-          show_my_running && show_my_total) {
-        show_all_partition = 1;
-        spheaders.my_running.visible = 0;
-        spheaders.my_waiting_resource.visible = 0;
-        spheaders.my_waiting_other.visible = 0;
-        spheaders.my_total.visible = 0;
-      } else
-        total_width += spheaders.my_running.column_width +
-                       spheaders.my_waiting_resource.column_width +
-                       spheaders.my_waiting_other.column_width +
-                       spheaders.my_total.column_width + 4;
+#ifdef __slurmdb_cluster_rec_t_defined
+      tmp_lenght = strlen(sp_str(strs, spData[i].cluster_name));
+      if (tmp_lenght > clusname_lenght) clusname_lenght = tmp_lenght;
+#endif
+      tmp_lenght = strlen(sp_str(strs, spData[i].partition_name));
+      if (tmp_lenght > partname_lenght) partname_lenght = tmp_lenght;
     }
 
-    if (spheaders.min_nodes.visible) {/* is column visible */
-      show_min_nodes = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].min_nodes != spData[k].min_nodes) {
-            show_min_nodes = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_min_nodes == 1) {
-        show_all_partition = 1;
-        spheaders.min_nodes.visible = 0;
-      } else
-        total_width += spheaders.min_nodes.column_width + 1;
+    if (show_given_partition == 1) {
+      for (i = 0; i < partition_count; i++)
+        spData[i].visible = sp_names_set_has(
+            &given_parts, sp_str(strs, spData[i].partition_name));
+      show_all_partition = 0;
     }
 
-    if (spheaders.max_nodes.visible) {/* is column visible */
-      show_max_nodes = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].max_nodes != spData[k].max_nodes) {
-            show_max_nodes = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_max_nodes == 1) {
-        show_all_partition = 1;
-        spheaders.max_nodes.visible = 0;
-      } else
-        total_width += spheaders.max_nodes.column_width + 1;
-    }
+    /* the headers are right aligned to the column width while printing */
+    if (partname_lenght > spheaders.col[SPART_COL_PARTITION].column_width)
+      spheaders.col[SPART_COL_PARTITION].column_width = partname_lenght;
+#ifdef __slurmdb_cluster_rec_t_defined
+    if (clusname_lenght > spheaders.col[SPART_COL_CLUSTER].column_width)
+      spheaders.col[SPART_COL_CLUSTER].column_width = clusname_lenght;
+#endif
 
-    if (spheaders.def_mem_per_cpu.visible) {/* is column visible */
-      show_def_mem_per_cpu = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].def_mem_per_cpu != spData[k].def_mem_per_cpu) {
-            show_def_mem_per_cpu = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_def_mem_per_cpu == 1) {
-        show_all_partition = 1;
-        spheaders.def_mem_per_cpu.visible = 0;
-      } else
-        total_width += spheaders.def_mem_per_cpu.column_width + 1;
-    }
+    /* If these column at default values, don't show. The JSON lines have
+     * the same keys, so all limits are written, as null if unset. */
+    if ((!show_parameter_L) && (!show_simple) && (!spheaders.given))
+      sp_headers_hide_unset(&spheaders, (show_json) ? UINT16_MAX : limits_set);
+    if (!spheaders.given)
+      sp_headers_set_group(&spheaders, SPART_GROUP_MY_JOBS, show_my_jobs);
 
-    if (spheaders.max_mem_per_cpu.visible) {/* is column visible */
-      show_max_mem_per_cpu = 1;
+    if (show_all_partition) {
       for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].max_mem_per_cpu != spData[k].max_mem_per_cpu) {
-            show_max_mem_per_cpu = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_max_mem_per_cpu == 1) {
-        show_all_partition = 1;
-        spheaders.max_mem_per_cpu.visible = 0;
-      } else
-        total_width += spheaders.max_mem_per_cpu.column_width + 1;
-    }
+        spData[i].visible = 1;
+      }
+    }
+
+    /* Common Values scanning */
+    /* reuse local show_xxx variables for different purpose */
+    show_all_partition = 0; /* are there common feature */
+    if ((!show_simple) && (!spheaders.given) && (!show_json))
+      show_all_partition =
+          sp_columns_common(&spheaders, spData, partition_count, strs,
+                            ((show_max_mem == 1) ? SPART_PRINT_MAX_MEM : 0),
+                            &first);
+
+    /* Output width calculation */
+    total_width = sp_columns_width(&spheaders);
+
+    if (metrics_file != NULL) {
+      /* the messages go to the stderr */
+      if (rounds == 0)
+        sp_strbuf_write(&spout, STDERR_FILENO);
+      else
+        sp_strbuf_clear(&spout);
+      sp_metrics_print(&spout, spData, partition_count, strs);
+      if (!sp_strbuf_save(&spout, metrics_file)) {
+        fprintf(stderr, "Can not write the metrics file %s: %s\n",
+                metrics_file, strerror(errno));
+        if (!watch_seconds) exit(1);
+      }
+      sp_strbuf_clear(&spout);
+    } else if (show_json) {
+      /* the partitions are written as JSON lines, and the messages go to the
+       * stderr */
+      sp_json_init(&spjson, STDOUT_FILENO);
+      for (i = 0; i < partition_count; i++)
+        sp_partition_json(&spjson, &(spData[i]), strs, &spheaders);
+      if (rounds == 0)
+        sp_strbuf_write(&spout, STDERR_FILENO);
+      else
+        sp_strbuf_clear(&spout);
+    } else {
+      /* Headers is printing */
+      sp_headers_print(&spout, &spheaders);
 
-    if (spheaders.max_cpus_per_node.visible) {/* is column visible */
-      show_max_cpus_per_node = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].max_cpus_per_node != spData[k].max_cpus_per_node) {
-            show_max_cpus_per_node = 0; /* it is not common */
-            break;
-          }
-        }
+#ifdef SPART_SHOW_STATEMENT
+      if (show_info) {
+        sp_strbuf_printf(&spout, "\n  %s ", SPART_STATEMENT_LINEPRE);
+        sp_seperator_print(&spout, '=', total_width);
+        sp_strbuf_printf(&spout, " %s\n\n", SPART_STATEMENT_LINEPOST);
       }
-      if (show_max_cpus_per_node == 1) {
-        show_all_partition = 1;
-        spheaders.max_cpus_per_node.visible = 0;
-      } else
-        total_width += spheaders.max_cpus_per_node.column_width + 1;
-    }
+#endif
 
-    if (spheaders.mjt_time.visible) {/* is column visible */
-      show_mjt_time = 1;
+      /* Output is printing */
       for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].mjt_time != spData[k].mjt_time) {
-            show_mjt_time = 0; /* it is not common */
-            break;
-          }
-        }
+        sp_partition_print(&spout, &(spData[i]), strs, &spheaders, show_max_mem,
+                           show_as_date, total_width);
       }
-      if (show_mjt_time == 1) {
-        show_all_partition = 1;
-        spheaders.mjt_time.visible = 0;
-      } else
-        total_width += spheaders.mjt_time.column_width + 1;
-    }
-
-    if (spheaders.djt_time.visible) {/* is column visible */
-      show_djt_time = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].djt_time != spData[k].djt_time) {
-            show_djt_time = 0; /* it is not common */
-            break;
+      if (show_verbose) {
+        for (i = 0; i < partition_count; i++) {
+          if (spData[i].visible == 1) {
+            sp_char_check(legends, SPART_INFO_STRING_SIZE,
+                          spData[i].partition_status, SPART_STATUS_SIZE);
           }
         }
       }
-      if (show_djt_time == 1) {
-        show_all_partition = 1;
-        spheaders.djt_time.visible = 0;
-      } else
-        total_width += spheaders.djt_time.column_width + 1;
-    }
 
-    if (spheaders.min_core.visible) {/* is column visible */
-      show_min_core = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].min_core != spData[k].min_core) {
-            show_min_core = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      /* is max_core visible */
-      if (show_max_mem) /* is column visible */
+      /* Common values are printing */
+      if (show_all_partition) {
         for (i = 0; i < partition_count; i++) {
-          if (spData[i].visible) /* is row visible */
-          {
-            if (spData[i].max_core != spData[k].max_core) {
-              show_min_core = 0; /* it is not common */
-              break;
-            }
-          }
-        }
-      if (show_min_core == 1) {
-        show_all_partition = 1;
-        spheaders.min_core.visible = 0;
-      } else
-        total_width += spheaders.min_core.column_width + 1;
-    }
-
-    if (spheaders.min_mem_gb.visible) {/* is column visible */
-      show_min_mem_gb = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (spData[i].min_mem_gb != spData[k].min_mem_gb) {
-            show_min_mem_gb = 0; /* it is not common */
-            break;
-          }
+          spData[i].visible = 0;
         }
-      }
-      /* is max_mem_gb visible */
-      if (show_max_mem) /* is column visible */
-        for (i = 0; i < partition_count; i++) {
-          if (spData[i].visible) /* is row visible */
-          {
-            if (spData[i].max_mem_gb != spData[k].max_mem_gb) {
-              show_min_core = 0; /* it is not common */
-              break;
+        spData[first].visible = 1;
+
+        sp_strbuf_catn(&spout, "\n", 1);
+        sp_columns_show_common(&spheaders);
+        sp_headers_print(&spout, &spheaders);
+        sp_partition_print(&spout, &(spData[first]), strs, &spheaders,
+                           show_max_mem, show_as_date, total_width);
+      }
+
+      if (show_verbose) {
+        sp_strbuf_cat(&spout, "\n   STATUS LABELS:\n");
+        for (i = 0; i < strlen(legends); i++) {
+          for (j = 0; j < legend_count; j++) {
+            if (legends[i] == legend_info[j][0]) {
+              sp_strbuf_cat(&spout, "              ");
+              sp_strbuf_cat(&spout, legend_info[j]);
+              sp_strbuf_catn(&spout, "\n", 1);
             }
           }
         }
-      if (show_min_mem_gb == 1) {
-        show_all_partition = 1;
-        spheaders.min_mem_gb.visible = 0;
-      } else
-        total_width += spheaders.min_mem_gb.column_width + 1;
-    }
-
-    if (spheaders.partition_qos.visible) {/* is column visible */
-      show_partition_qos = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (strncmp(spData[i].partition_qos, spData[k].partition_qos,
-                      SPART_MAX_COLUMN_SIZE) != 0) {
-            show_partition_qos = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_partition_qos == 1) {
-        show_all_partition = 1;
-        spheaders.partition_qos.visible = 0;
-      } else
-        total_width += spheaders.partition_qos.column_width + 1;
-    }
-
-    if (spheaders.gres.visible) {/* is column visible */
-      show_gres = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (strncmp(spData[i].gres, spData[k].gres, SPART_MAX_COLUMN_SIZE) !=
-              0) {
-            show_gres = 0; /* it is not common */
-            break;
-          }
-        }
       }
-      if (show_gres == 1) {
-        show_all_partition = 1;
-        spheaders.gres.visible = 0;
-      } else
-        total_width += spheaders.gres.column_width + 1;
-    }
 
-    if (spheaders.features.visible) {/* is column visible */
-      show_features = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (strncmp(spData[i].features, spData[k].features,
-                      SPART_MAX_COLUMN_SIZE) != 0) {
-            show_features = 0; /* it is not common */
-            break;
-          }
-        }
-      }
-      if (show_features == 1) {
-        show_all_partition = 1;
-        spheaders.features.visible = 0;
-      } else
-        total_width += spheaders.features.column_width + 1;
-    }
-
-#ifdef __slurmdb_cluster_rec_t_defined
-    if (spheaders.cluster_name.visible) {/* is column visible */
-      show_cluster_name = 1;
-      for (i = 0; i < partition_count; i++) {
-        if (spData[i].visible) /* is row visible */
-        {
-          if (strncmp(spData[i].cluster_name, spData[k].cluster_name,
-                      SPART_MAX_COLUMN_SIZE) != 0) {
-            show_cluster_name = 0; /* it is not common */
-            break;
+#ifdef SPART_SHOW_STATEMENT
+      /* Statement is printing */
+      fo = fopen(SPART_STATEMENT_DIR SPART_STATEMENT_FILE, "r");
+      if (fo) {
+        sp_strbuf_printf(&spout, "\n  %s ", SPART_STATEMENT_LINEPRE);
+        sp_seperator_print(&spout, '=', total_width);
+        sp_strbuf_printf(&spout, " %s\n", SPART_STATEMENT_LINEPOST);
+        while (fgets(re_str, SPART_INFO_STRING_SIZE, fo)) {
+          /* To correctly frame some wide chars, but not all */
+          m = 0;
+          for (k = 0; (re_str[k] != '\0') && k < SPART_INFO_STRING_SIZE; k++) {
+            if ((re_str[k] < -58) && (re_str[k] > -62)) m++;
+            if (re_str[k] == '\n') re_str[k] = '\0';
           }
+          // printf("  %s %-*s %s\n", SPART_STATEMENT_LINEPRE, 92 + m, re_str,
+          sp_strbuf_printf(&spout, "  %s %-*s %s\n", SPART_STATEMENT_LINEPRE,
+                           total_width, re_str, SPART_STATEMENT_LINEPOST);
         }
+        sp_strbuf_printf(&spout, "  %s ", SPART_STATEMENT_LINEPRE);
+        sp_seperator_print(&spout, '=', total_width);
+        sp_strbuf_printf(&spout, " %s\n", SPART_STATEMENT_LINEPOST);
+        pclose(fo);
       }
-      if (show_cluster_name == 1) {
-        show_all_partition = 1;
-        spheaders.cluster_name.visible = 0;
-      } else
-        total_width += spheaders.cluster_name.column_width + 1;
-    }
-#endif
-  }
-  /* Headers is printing */
-  sp_headers_print(&spheaders);
-
-#ifdef SPART_SHOW_STATEMENT
-  if (show_info) {
-    printf("\n  %s ", SPART_STATEMENT_LINEPRE);
-    sp_seperator_print('=', total_width);
-    printf(" %s\n\n", SPART_STATEMENT_LINEPOST);
-  }
-#endif
-
-  /* Output is printing */
-  for (i = 0; i < partition_count; i++) {
-    sp_partition_print(&(spData[i]), &spheaders, show_max_mem, show_as_date,
-                       total_width);
-  }
-  if (show_verbose) {
-    for (i = 0; i < partition_count; i++) {
-      if (spData[i].visible == 1) {
-        sp_char_check(legends, SPART_INFO_STRING_SIZE,
-                      spData[i].partition_status, SPART_MAX_COLUMN_SIZE);
-      }
-    }
-  }
-
-  /* Common values are printing */
-  if (show_all_partition) {
-    for (i = 0; i < partition_count; i++) {
-      spData[i].visible = 0;
-    }
-    spData[k].visible = 1;
-
-#ifdef __slurmdb_cluster_rec_t_defined
-    spheaders.cluster_name.visible = 0;
-#endif
-    spheaders.partition_name.visible = 0;
-    spheaders.partition_status.visible = 0;
-    spheaders.free_cpu.visible = 0;
-    spheaders.total_cpu.visible = 0;
-    spheaders.free_node.visible = 0;
-    spheaders.total_node.visible = 0;
-    spheaders.waiting_resource.visible = 0;
-    spheaders.waiting_other.visible = 0;
-    spheaders.my_running.visible = 0;
-    spheaders.my_waiting_resource.visible = 0;
-    spheaders.my_waiting_other.visible = 0;
-    spheaders.my_total.visible = 0;
-    spheaders.min_nodes.visible = 0;
-    spheaders.max_nodes.visible = 0;
-    spheaders.max_cpus_per_node.visible = 0;
-    spheaders.max_mem_per_cpu.visible = 0;
-    spheaders.def_mem_per_cpu.visible = 0;
-    spheaders.djt_time.visible = 0;
-    spheaders.mjt_time.visible = 0;
-    spheaders.min_core.visible = 0;
-    spheaders.min_mem_gb.visible = 0;
-    spheaders.partition_qos.visible = 0;
-    spheaders.gres.visible = 0;
-    spheaders.features.visible = 0;
-
-    printf("\n");
-#ifdef __slurmdb_cluster_rec_t_defined
-    if (show_cluster_name) spheaders.cluster_name.visible = 1;
 #endif
-    if (show_my_running && show_my_waiting_resource && show_my_waiting_other &&
-        show_my_total) {
-      spheaders.my_running.visible = 1;
-      spheaders.my_waiting_resource.visible = 1;
-      spheaders.my_waiting_other.visible = 1;
-      spheaders.my_total.visible = 1;
-    }
-    if (show_min_nodes) spheaders.min_nodes.visible = 1;
-    if (show_max_nodes) spheaders.max_nodes.visible = 1;
-    if (show_max_cpus_per_node) spheaders.max_cpus_per_node.visible = 1;
-    if (show_def_mem_per_cpu) spheaders.def_mem_per_cpu.visible = 1;
-    if (show_max_mem_per_cpu) spheaders.max_mem_per_cpu.visible = 1;
-    if (show_djt_time) spheaders.djt_time.visible = 1;
-    if (show_mjt_time) spheaders.mjt_time.visible = 1;
-    if (show_min_core) spheaders.min_core.visible = 1;
-    if (show_min_mem_gb) spheaders.min_mem_gb.visible = 1;
-    if (show_partition_qos) spheaders.partition_qos.visible = 1;
-    if (show_gres) spheaders.gres.visible = 1;
-    if (show_features) spheaders.features.visible = 1;
-    spheaders.hspace.visible = 1;
-    sp_headers_print(&spheaders);
-    sp_partition_print(&(spData[k]), &spheaders, show_max_mem, show_as_date,
-                       total_width);
-  }
-
-  if (show_verbose) {
-    printf("\n   STATUS LABELS:\n");
-    for (i = 0; i < strlen(legends); i++) {
-      for (j = 0; j < legend_count; j++) {
-        if (legends[i] == legend_info[j][0]) {
-          printf("              %s\n", legend_info[j]);
+      if (watch_seconds) {
+        sp_watch_show(&spwatch, &spout, NULL);
+      } else if (spbatch.dir != NULL) {
+        if (!sp_batch_write(&spbatch, rounds, &spout)) {
+          fprintf(stderr, "Can not write the output of %s to %s: %s\n",
+                  spbatch.users[rounds].user_name, spbatch.dir,
+                  strerror(errno));
+          exit(1);
         }
+      } else {
+        sp_strbuf_write(&spout, STDOUT_FILENO);
       }
     }
-  }
 
-#ifdef SPART_SHOW_STATEMENT
-  /* Statement is printing */
-  fo = fopen(SPART_STATEMENT_DIR SPART_STATEMENT_FILE, "r");
-  if (fo) {
-    printf("\n  %s ", SPART_STATEMENT_LINEPRE);
-    sp_seperator_print('=', total_width);
-    printf(" %s\n", SPART_STATEMENT_LINEPOST);
-    while (fgets(re_str, SPART_INFO_STRING_SIZE, fo)) {
-      /* To correctly frame some wide chars, but not all */
-      m = 0;
-      for (k = 0; (re_str[k] != '\0') && k < SPART_INFO_STRING_SIZE; k++) {
-        if ((re_str[k] < -58) && (re_str[k] > -62)) m++;
-        if (re_str[k] == '\n') re_str[k] = '\0';
-      }
-      // printf("  %s %-*s %s\n", SPART_STATEMENT_LINEPRE, 92 + m, re_str,
-      printf("  %s %-*s %s\n", SPART_STATEMENT_LINEPRE, total_width, re_str,
-             SPART_STATEMENT_LINEPOST);
-    }
-    printf("  %s ", SPART_STATEMENT_LINEPRE);
-    sp_seperator_print('=', total_width);
-    printf(" %s\n", SPART_STATEMENT_LINEPOST);
-    pclose(fo);
+    /* the batch continues with the next user */
+    if ((!watch_seconds) && (rounds + 1 >= spbatch.count)) break;
+    rounds++;
   }
+
+#ifdef SPART_SHOW_PROFILE
+  sp_arena_profile("run", &(splib.arena));
+  sp_arena_profile("nodes", &(splib.node_arena));
+  sp_arena_profile("assoc", &(spuser.assoc_arena));
+  sp_arena_profile("groups", &(spuser.group_arena));
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    fprintf(stderr, "spart: %-12s %8ld KB\n", "peak rss", usage.ru_maxrss);
 #endif
   /* free allocations */
-  for (k = 0; k < user_acct_count; k++) {
-    free(user_acct[k]);
-  }
-  free(user_acct);
-  for (k = 0; k < user_qos_count; k++) {
-    free(user_qos[k]);
-  }
-  free(user_qos);
-  for (k = 0; k < user_group_count; k++) {
-    free(user_group[k]);
-  }
-  free(user_group);
-
-  free(spData);
-  slurm_free_job_info_msg(job_buffer_ptr);
-  slurm_free_node_info_msg(node_buffer_ptr);
-  slurm_free_partition_info_msg(part_buffer_ptr);
-  slurm_free_ctl_conf(conf_info_msg_ptr);
+  sp_user_free(&spuser);
+  sp_lib_free(&splib);
+  sp_strbuf_free(&spout);
+  if (watch_seconds) sp_watch_free(&spwatch);
+  if (spbatch.dir != NULL) sp_batch_free(&spbatch);
+  if (replay_file != NULL) sp_record_free(&sprec);
+#ifdef SPART_USE_SNAPSHOT
+  if (from_cache) sp_snap_unmap(&spsnap);
+#endif
+  if (show_given_partition) sp_hash_free(&given_parts);
+  free(user_jobs.items);
   exit(0);
 }
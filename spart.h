@@ -17,12 +17,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "spart_arena.h"
+#include "spart_hash.h"
+#include "spart_pool.h"
 
 /* for UHeM-ITU-Turkey specific settings */
 /* #define SPART_COMPILE_FOR_UHEM */
 
 /* #define SPART_SHOW_STATEMENT */
 
+/* if SPART_SHOW_PROFILE is defined, the spart prints the time
+ * spent for each slurm request to the stderr. At the exit, it also
+ * prints the allocation, block and byte counts of each memory arena,
+ * and the peak resident memory of the process. */
+/* #define SPART_SHOW_PROFILE */
+
 /* if you want to use STATEMENT feature, uncomment
  * SPART_SHOW_STATEMENT at upper line, and set
  * SPART_STATEMENT_DIR to show the correct directory
@@ -69,10 +78,49 @@
 #define SPART_STATEMENT_QUEPOST ".txt"
 #endif
 
+/* if you want to share the slurm data between the spart calls of all
+ * users of a node, uncomment SPART_CACHE_DIR. The spart calls of the
+ * owner of SPART_CACHE_DIR (e.g. a dedicated user, run by cron) save a
+ * snapshot of the partitions there, and the calls in the next
+ * SPART_CACHE_TTL seconds read the snapshot instead of asking the
+ * slurmctld. Only the snapshots of the owner are read, so the others
+ * should not be able to write to SPART_CACHE_DIR. If the slurm settings
+ * have info restrictions (PrivateData), nothing is saved. */
+/* #define SPART_CACHE_DIR "/var/cache/spart/" */
+#ifdef SPART_CACHE_DIR
+#define SPART_CACHE_FILE "spart_snapshot_"
+#define SPART_CACHE_TTL 30
+#endif
+
+/* if you want to run a spart server, which keeps the slurm data in the
+ * memory, uncomment SPART_SERVER_SOCKET. The server is started with the
+ * "spart --server" command, and it refreshes the data in every
+ * SPART_SERVER_INTERVAL seconds. The spart calls ask the server at first,
+ * and they ask the slurmctld only if the server is not running. */
+/* #define SPART_SERVER_SOCKET "/var/run/spart.sock" */
+#ifdef SPART_SERVER_SOCKET
+#define SPART_SERVER_INTERVAL 10
+#define SPART_SERVER_MAGIC 0x53505254
+#endif
+
+/* The accounts and QOSs of the user are read from the slurm database. If
+ * you want to keep them in a cache file of the user for
+ * SPART_ASSOC_CACHE_TTL seconds, uncomment SPART_ASSOC_CACHE_TTL. The
+ * "spart -i" command always reads them from the database. */
+/* #define SPART_ASSOC_CACHE_TTL 600 */
+#ifdef SPART_ASSOC_CACHE_TTL
+#define SPART_ASSOC_CACHE_DIR "/tmp/"
+#endif
+
+#if defined(SPART_CACHE_DIR) || defined(SPART_SERVER_SOCKET)
+#define SPART_USE_SNAPSHOT
+#endif
+
 #define SPART_INFO_STRING_SIZE 4096
-#define SPART_GRES_ARRAY_SIZE 256
 #define SPART_MAX_COLUMN_SIZE 64
+#define SPART_STATUS_SIZE 16
 #define SPART_MAX_GROUP_SIZE 32
+#define SPART_MAX_COLUMNS 32
 
 char *legend_info[] = {
     "* : default partition (default queue)",
@@ -97,7 +145,9 @@ int sp_spart_usage() {
 #ifdef __slurmdb_cluster_rec_t_defined
       "[-c] "
 #endif
-      "[-g] [-i] [-t] [-f] [-l] [-s] [-J] [-p PARTITION_LIST] [-v] [-h]\n\n");
+      "[-g] [-i] [-t] [-f] [-l] [-s] [-J] [-p PARTITION_LIST] [-o COLUMN_LIST]"
+      "\n\t[-j] [--watch SECONDS] [--metrics FILE] [--batch USER_LIST DIR]"
+      "\n\t[--record FILE] [--replay FILE] [-v] [-h]\n\n");
   printf(
       "This program shows brief partition info with core count of available "
       "nodes and pending jobs.\n\n");
@@ -210,11 +260,69 @@ int sp_spart_usage() {
   printf(
       "\t-p PARTITION_LIST\n\t\tthe output shows only the partitions which "
       "given with comma-seperated \n\t\tPARTITION_LIST.\n\n");
+  printf(
+      "\t-o COLUMN_LIST\n\t\tonly the columns which given with "
+      "comma-seperated COLUMN_LIST\n\t\twill be shown, in the given order. "
+      "A column width can be given\n\t\tafter a colon, such as "
+      "partition:16. The COMMON VALUES are not\n\t\tused, and the values "
+      "of the other columns are not computed. The\n\t\tcolumns are: "
+#ifdef __slurmdb_cluster_rec_t_defined
+      "cluster, "
+#endif
+      "partition, status, free_cores,\n\t\ttotal_cores, "
+      "resource_pending, other_pending, free_nodes,\n\t\ttotal_nodes, "
+      "my_running, my_resource_pending, my_other_pending,\n\t\tmy_total, "
+      "min_nodes, max_nodes, max_cpus_per_node, def_mem, max_mem,\n\t\t"
+      "def_time, max_time, cores, node_mem, qos, gres, features.\n\n");
   printf(
       "\t-l\tall posible columns will be shown, except"
       " the federated clusters column.\n\n");
+  printf(
+      "\t-j\teach partition is written as a JSON object at a line, with "
+      "the exact\n\t\tvalues. The memory is given as MB at the keys "
+      "ending with _mb,\n\t\tthe times as minutes, and the unlimited "
+      "values as null. All\n\t\tlines have the same keys, the COMMON "
+      "VALUES are not used. The\n\t\tmessages are written to the "
+      "stderr.\n\n");
+  printf(
+      "\t--watch SECONDS\n\t\tthe output is refreshed at every SECONDS, "
+      "until it is stopped with\n\t\tCtrl-C. Only the changed parts of the "
+      "screen are written again.\n\t\tWith -j, the partitions are written "
+      "again when they are changed.\n\n");
+  printf(
+      "\t--metrics FILE\n\t\tthe free and total cores and nodes, the "
+      "pending cores, and the\n\t\tmin and max cores and memory of the "
+      "nodes of each partition\n\t\tare written to the FILE as "
+      "OpenMetrics gauges, instead of the\n\t\toutput. The FILE is "
+      "replaced at once, so a reader never sees a\n\t\tpartial file. "
+      "With --watch, the FILE is written again when\n\t\tthe values are "
+      "changed.\n\n");
+  printf(
+      "\t--batch USER_LIST DIR\n\t\tthe output of each user in the "
+      "comma-seperated USER_LIST\n\t\tis written to the DIR/USERNAME "
+      "file. The slurm data is\n\t\tloaded once for all users, and the "
+      "accounts and QOSs of all\n\t\tusers are read with one query. If "
+      "USER_LIST is all, the users\n\t\twhich have jobs in the queue are "
+      "used.\n\n");
+  printf(
+      "\t--record FILE\n\t\tthe slurm data and the user info, which are "
+      "read by the spart,\n\t\tare also written to the FILE. The record "
+      "has all partitions\n\t\tand columns, so it can be replayed with "
+      "other parameters.\n\n");
+  printf(
+      "\t--replay FILE\n\t\tthe slurm data and the user info are read "
+      "from the FILE, which\n\t\tis written with --record, instead of "
+      "the slurm. The output is\n\t\tmade by the same code, so a slow "
+      "case can be repeated and\n\t\tprofiled without the slurm.\n\n");
   printf("\t-v\tshows info about STATUS LABELS.\n\n");
   printf("\t-h\tshows this usage text.\n\n");
+#ifdef SPART_SERVER_SOCKET
+  printf(
+      "\t--server [SNAPSHOT_FILE]\n\t\truns the spart server, which "
+      "answers the spart calls of\n\t\tthis node. If SNAPSHOT_FILE is "
+      "given, the data is read from\n\t\tthis file instead of the "
+      "slurm.\n\n");
+#endif
 #ifdef SPART_COMPILE_FOR_UHEM
   printf("This is UHeM Version of the spart command.\n");
 #endif
@@ -222,6 +330,19 @@ int sp_spart_usage() {
   // exit(1);
 }
 
+/* The set_limits bits of the partition info */
+#define SPART_SET_MIN_NODES 0x0001
+#define SPART_SET_MAX_NODES 0x0002
+#define SPART_SET_MAX_CPUS_PER_NODE 0x0004
+#define SPART_SET_DEF_MEM_PER_CPU 0x0008
+#define SPART_SET_MAX_MEM_PER_CPU 0x0010
+#define SPART_SET_MJT_TIME 0x0020
+#define SPART_SET_DJT_TIME 0x0040
+#define SPART_SET_PARTITION_QOS 0x0080
+/* the memory limits are per cpu, not per node */
+#define SPART_DEF_MEM_IS_PER_CPU 0x0100
+#define SPART_MAX_MEM_IS_PER_CPU 0x0200
+
 /* To store partition info */
 typedef struct sp_part_info {
   uint32_t free_cpu;
@@ -232,6 +353,7 @@ typedef struct sp_part_info {
   uint32_t waiting_other;
   uint32_t min_nodes;
   uint32_t max_nodes;
+  /* the memory limits as MB */
   uint64_t def_mem_per_cpu;
   uint64_t max_mem_per_cpu;
   uint32_t max_cpus_per_node;
@@ -241,8 +363,9 @@ typedef struct sp_part_info {
   uint32_t djt_time;
   uint32_t min_core;
   uint32_t max_core;
-  uint16_t min_mem_gb;
-  uint16_t max_mem_gb;
+  /* the memory of the nodes as MB */
+  uint32_t min_mem_mb;
+  uint32_t max_mem_mb;
   uint16_t visible;
 #ifdef SPART_SHOW_STATEMENT
   uint16_t show_statement;
@@ -252,61 +375,301 @@ typedef struct sp_part_info {
   uint32_t my_running;
   uint32_t my_total;
 
-  char partition_name[SPART_MAX_COLUMN_SIZE];
-#ifdef __slurmdb_cluster_rec_t_defined
+  /* user independent partition settings, to set the partition_status
+   * for the user */
+  uint32_t flags;
+  uint16_t state_up;
+  /* limits which are not at their default values, SPART_SET_ bits */
+  uint16_t set_limits;
+  char partition_status[SPART_STATUS_SIZE];
+
+  /* the offsets of the strings in the sp_strpool_t */
+  uint32_t partition_name;
+  uint32_t cluster_name;
+  uint32_t partition_qos;
+  uint32_t gres;
+  uint32_t features;
+  uint32_t allow_accounts;
+  uint32_t deny_accounts;
+  uint32_t allow_qos;
+  uint32_t deny_qos;
+  uint32_t allow_groups;
+} sp_part_info_t;
+
+/* Job counts of a user at a partition */
+typedef struct sp_user_jobs {
+  uint32_t user_id;
+  uint32_t partition;
+  uint32_t running;
+  uint32_t waiting_resource;
+  uint32_t waiting_other;
+  uint32_t total;
+} sp_user_jobs_t;
+
+/* A growable list of user job counts */
+typedef struct sp_user_jobs_list {
+  uint32_t count;
+  uint32_t size;
+  sp_user_jobs_t *items;
+} sp_user_jobs_list_t;
+
+/* A partition snapshot, which is read from the cache file */
+typedef struct sp_snapshot {
+  void *map;
+  size_t size;
+  /* the memory, which is received from the spart server */
+  char *buffer;
+  time_t created;
+  uint16_t private_data;
   char cluster_name[SPART_MAX_COLUMN_SIZE];
+  uint32_t partition_count;
+  sp_part_info_t *spData;
+  /* the strings of the partitions, in the memory map or the buffer */
+  sp_strpool_t strings;
+  uint32_t user_jobs_count;
+  sp_user_jobs_t *user_jobs;
+} sp_snapshot_t;
+
+/* The accounts, the QOSs or the groups of the user as a set, to check the
+ * access lists of the partitions */
+typedef struct sp_user_set {
+  /* name to index, the keys point into the user lists */
+  sp_hash_t names;
+  uint32_t count;
+  /* the stamp of the last list, which the name is found in */
+  uint32_t *seen;
+  uint32_t stamp;
+  /* list string to the found count, many partitions have the same lists */
+  sp_hash_t results;
+} sp_user_set_t;
+
+/* To store the identity of the user */
+typedef struct sp_user_info {
+  char user_name[SPART_INFO_STRING_SIZE];
+  int user_id;
+  uint32_t group_id;
+  int user_acct_count;
+  char **user_acct;
+  int user_qos_count;
+  char **user_qos;
+  int user_group_count;
+  char **user_group;
+  /* the lists are read by different threads, so they have own arenas */
+  sp_arena_t assoc_arena;
+  sp_arena_t group_arena;
+  /* built by sp_user_sets_build, after all lists are read */
+  sp_user_set_t acct_set;
+  sp_user_set_t qos_set;
+  sp_user_set_t group_set;
+} sp_user_info_t;
+
+/* The slurm requests which are sent concurrently */
+#define SPART_FETCH_CONF 0
+#define SPART_FETCH_JOBS 1
+#define SPART_FETCH_NODES 2
+#define SPART_FETCH_PARTITIONS 3
+#define SPART_FETCH_ASSOC 4
+#define SPART_FETCH_GROUPS 5
+#define SPART_FETCH_COUNT 6
+#define SPART_FETCH_SLURM                                  \
+  ((1 << SPART_FETCH_CONF) | (1 << SPART_FETCH_JOBS) |     \
+   (1 << SPART_FETCH_NODES) | (1 << SPART_FETCH_PARTITIONS))
+
+/* The computations which are needed by the visible columns */
+#define SPART_PLAN_MY_JOBS 0x0001
+#define SPART_PLAN_WAITING 0x0002
+/* free cores and free nodes */
+#define SPART_PLAN_NODES 0x0004
+/* min/max cores and memory of the nodes */
+#define SPART_PLAN_NODE_LIMITS 0x0008
+#define SPART_PLAN_GRES 0x0010
+#define SPART_PLAN_FEATURES 0x0020
+#define SPART_PLAN_QOS 0x0040
+#define SPART_PLAN_ALL 0x007f
+/* the values of the --metrics output */
+#define SPART_PLAN_METRICS \
+  (SPART_PLAN_WAITING | SPART_PLAN_NODES | SPART_PLAN_NODE_LIMITS)
+
+/* What will be loaded and computed, derived from the column visibility */
+typedef struct sp_plan {
+  /* SPART_FETCH_ bits of the slurm requests */
+  uint16_t wanted;
+  /* SPART_PLAN_ bits */
+  uint16_t compute;
+} sp_plan_t;
+
+/* The result of a slurm request */
+typedef struct sp_fetch_request {
+  /* slurm error number, 0 on success */
+  int error;
+  /* elapsed wall time as seconds */
+  double seconds;
+  /* 1 if new data is loaded, 0 if the old data is still valid */
+  int changed;
+} sp_fetch_request_t;
+
+/* To store the loaded slurm data */
+typedef struct sp_fetch {
+#if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
+  slurm_conf_t *conf_info_msg_ptr;
+#else
+  slurm_ctl_conf_t *conf_info_msg_ptr;
 #endif
-  char partition_qos[SPART_MAX_COLUMN_SIZE];
-  char gres[SPART_INFO_STRING_SIZE];
-  char features[SPART_INFO_STRING_SIZE];
-  char partition_status[SPART_MAX_COLUMN_SIZE];
-} sp_part_info_t;
+  job_info_msg_t *job_buffer_ptr;
+  node_info_msg_t *node_buffer_ptr;
+  partition_info_msg_t *part_buffer_ptr;
+  uint16_t show_partition;
+  sp_user_info_t *user;
+
+  /* SPART_FETCH_ bits of the requests which will be sent */
+  uint16_t wanted;
+  /* read the accounts and the QOSs from the database, not from cache */
+  int assoc_refresh;
+  sp_fetch_request_t request[SPART_FETCH_COUNT];
+} sp_fetch_t;
+
+/* To store the node values which are used by the partitions, computed
+ * once for each node */
+typedef struct sp_node_info {
+  uint32_t cpus;
+  uint32_t alloc_cpus;
+  /* real_memory as MB */
+  uint32_t mem;
+  /* not drained, down or unknown */
+  uint16_t usable;
+} sp_node_info_t;
+
+/* To find partitions by name. The partitions which have the same name
+ * (from the federated clusters) are chained with the next array. */
+typedef struct sp_part_index {
+  sp_hash_t names;
+  uint32_t *next;
+  /* last job counted for the partition, to count a job once */
+  uint32_t *last_job;
+} sp_part_index_t;
 
-/* To storing info about a gres */
-typedef struct sp_gres_info {
+/* The query, which is sent by the spart to the spart server */
+typedef struct sp_server_query {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t show_partition;
+} sp_server_query_t;
+
+/* The data of the spart server for a show_partition value */
+typedef struct sp_server_view {
+  uint16_t show_partition;
+  sp_fetch_t spf;
+  sp_user_jobs_list_t user_jobs;
+  uint16_t private_data;
+  /* the serialized partitions, which are sent to all clients */
+  char *parts;
+  size_t parts_size;
+} sp_server_view_t;
+
+/* The token ids of a node, which are in the ids array of the sp_tokens */
+typedef struct sp_node_tokens {
+  uint32_t first;
+  uint32_t count;
+  uint32_t parsed;
+} sp_node_tokens_t;
+
+/* The gres or feature tokens of the nodes. Each distinct token gets an id,
+ * and the counts of the current partition are kept by id. */
+typedef struct sp_tokens {
+  /* token to id, the keys point into the node strings */
+  sp_hash_t index;
   uint32_t count;
-  char gres_name[SPART_INFO_STRING_SIZE];
-} sp_gres_info_t;
+  uint32_t size;
+  const char **names;
+  uint32_t *lens;
+  /* the ids of the current partition in the first seen order, and the
+   * counts of all ids */
+  uint32_t used;
+  uint32_t *order;
+  uint32_t *counts;
+  /* the list of each node is parsed once, at its first partition */
+  sp_node_tokens_t *nodes;
+  uint32_t *ids;
+  uint32_t ids_used;
+  uint32_t ids_size;
+} sp_tokens_t;
+
+/* The kinds of the output columns */
+/* always shown, and always in the output width */
+#define SPART_COLUMN_FIXED 0
+/* hidden and shown at the COMMON VALUES, if it is same for all partitions */
+#define SPART_COLUMN_COMMON 1
+/* the COMMON VALUES label */
+#define SPART_COLUMN_LABEL 2
+
+/* The groups of columns, which are hidden together */
+#define SPART_GROUP_NONE 0
+#define SPART_GROUP_MY_JOBS 1
+
+/* The display rules of the columns */
+/* shown with the -l parameter */
+#define SPART_RULE_LONG 0x0001
+/* hidden with the -s parameter */
+#define SPART_RULE_DETAIL 0x0002
+/* hidden, if no partition sets its limit */
+#define SPART_RULE_LIMIT 0x0004
+
+/* The printing options of the column values */
+#define SPART_PRINT_MAX_MEM 0x0001
+#define SPART_PRINT_AS_DATE 0x0002
+
+/* The output columns, as the indexes of sp_columns and the headers */
+#define SPART_COL_LABEL 0
+#ifdef __slurmdb_cluster_rec_t_defined
+#define SPART_COL_CLUSTER 1
+#define SPART_COL_PARTITION 2
+#else
+#define SPART_COL_PARTITION 1
+#endif
+#define SPART_COL_STATUS (SPART_COL_PARTITION + 1)
+#define SPART_COL_FREE_CORES (SPART_COL_PARTITION + 2)
+#define SPART_COL_TOTAL_CORES (SPART_COL_PARTITION + 3)
+#define SPART_COL_RESOURCE_PENDING (SPART_COL_PARTITION + 4)
+#define SPART_COL_OTHER_PENDING (SPART_COL_PARTITION + 5)
+#define SPART_COL_FREE_NODES (SPART_COL_PARTITION + 6)
+#define SPART_COL_TOTAL_NODES (SPART_COL_PARTITION + 7)
+#define SPART_COL_MY_RUNNING (SPART_COL_PARTITION + 8)
+#define SPART_COL_MY_RESOURCE_PENDING (SPART_COL_PARTITION + 9)
+#define SPART_COL_MY_OTHER_PENDING (SPART_COL_PARTITION + 10)
+#define SPART_COL_MY_TOTAL (SPART_COL_PARTITION + 11)
+#define SPART_COL_MIN_NODES (SPART_COL_PARTITION + 12)
+#define SPART_COL_MAX_NODES (SPART_COL_PARTITION + 13)
+#define SPART_COL_MAX_CPUS_PER_NODE (SPART_COL_PARTITION + 14)
+#define SPART_COL_DEF_MEM (SPART_COL_PARTITION + 15)
+#define SPART_COL_MAX_MEM (SPART_COL_PARTITION + 16)
+#define SPART_COL_DEF_TIME (SPART_COL_PARTITION + 17)
+#define SPART_COL_MAX_TIME (SPART_COL_PARTITION + 18)
+#define SPART_COL_CORES (SPART_COL_PARTITION + 19)
+#define SPART_COL_NODE_MEM (SPART_COL_PARTITION + 20)
+#define SPART_COL_QOS (SPART_COL_PARTITION + 21)
+#define SPART_COL_GRES (SPART_COL_PARTITION + 22)
+#define SPART_COL_FEATURES (SPART_COL_PARTITION + 23)
+#define SPART_COLUMN_COUNT (SPART_COL_PARTITION + 24)
 
 /* An output column header info */
 typedef struct sp_column_header {
-  char line1[SPART_INFO_STRING_SIZE];
-  char line2[SPART_INFO_STRING_SIZE];
+  const char *line1;
+  const char *line2;
   uint16_t column_width;
   uint16_t visible;
+  /* the column has the same value at all visible partitions */
+  uint16_t common;
 } sp_column_header_t;
 
 /* To storing Output headers */
 typedef struct sp_headers {
-  sp_column_header_t hspace;
-#ifdef __slurmdb_cluster_rec_t_defined
-  sp_column_header_t cluster_name;
-#endif
-  sp_column_header_t partition_name;
-  sp_column_header_t partition_status;
-  sp_column_header_t free_cpu;
-  sp_column_header_t total_cpu;
-  sp_column_header_t free_node;
-  sp_column_header_t total_node;
-  sp_column_header_t waiting_resource;
-  sp_column_header_t waiting_other;
-  sp_column_header_t my_running;
-  sp_column_header_t my_waiting_resource;
-  sp_column_header_t my_waiting_other;
-  sp_column_header_t my_total;
-  sp_column_header_t min_nodes;
-  sp_column_header_t max_nodes;
-  sp_column_header_t max_cpus_per_node;
-  sp_column_header_t def_mem_per_cpu;
-  sp_column_header_t max_mem_per_cpu;
-  /* MaxJobTime */
-  sp_column_header_t mjt_time;
-  sp_column_header_t djt_time;
-  sp_column_header_t min_core;
-  sp_column_header_t min_mem_gb;
-  sp_column_header_t partition_qos;
-  sp_column_header_t gres;
-  sp_column_header_t features;
+  /* the headers of the columns, at the SPART_COL_ indexes */
+  sp_column_header_t col[SPART_COLUMN_COUNT];
+  /* the printing order of the columns, as the indexes of sp_columns */
+  uint16_t order[SPART_MAX_COLUMNS];
+  uint16_t order_count;
+  /* the columns are given with the -o parameter */
+  uint16_t given;
 } sp_headers_t;
 
 #endif /* SPART_SPART_H_incl */
@@ -0,0 +1,96 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_ARENA_H_incl
+#define SPART_SPART_ARENA_H_incl
+
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPART_ARENA_BLOCK_SIZE 65536
+#define SPART_ARENA_ALIGN 16
+
+/* A block of the arena, the memory follows the header */
+typedef struct sp_arena_block {
+  struct sp_arena_block *next;
+  size_t used;
+  size_t size;
+} sp_arena_block_t;
+
+/* The memory of a run is taken from big blocks, and all of it is freed at
+ * once. A zeroed arena is empty. The arena is not thread safe. */
+typedef struct sp_arena {
+  sp_arena_block_t *head;
+  /* for the profile */
+  uint32_t allocs;
+  uint32_t blocks;
+  size_t bytes;
+} sp_arena_t;
+
+/* Returns zeroed memory, which lives until sp_arena_free */
+void *sp_arena_alloc(sp_arena_t *a, size_t size) {
+  sp_arena_block_t *b = a->head;
+  size_t head_size = (sizeof(sp_arena_block_t) + SPART_ARENA_ALIGN - 1) &
+                     ~(size_t)(SPART_ARENA_ALIGN - 1);
+  size_t block_size = SPART_ARENA_BLOCK_SIZE;
+  void *p;
+
+  size = (size + SPART_ARENA_ALIGN - 1) & ~(size_t)(SPART_ARENA_ALIGN - 1);
+  a->allocs++;
+  a->bytes += size;
+  if ((b == NULL) || (b->used + size > b->size)) {
+    if (size > SPART_ARENA_BLOCK_SIZE / 4) block_size = size;
+    b = calloc(1, head_size + block_size);
+    if (b == NULL) {
+      slurm_perror("Can not allocate memory");
+      exit(1);
+    }
+    a->blocks++;
+    b->size = block_size;
+    /* a big allocation does not end the current block */
+    if ((block_size != SPART_ARENA_BLOCK_SIZE) && (a->head != NULL)) {
+      b->next = a->head->next;
+      a->head->next = b;
+    } else {
+      b->next = a->head;
+      a->head = b;
+    }
+  }
+  p = (char *)b + head_size + b->used;
+  b->used += size;
+  return p;
+}
+
+char *sp_arena_strdup(sp_arena_t *a, const char *str) {
+  size_t len = strlen(str);
+  char *p = sp_arena_alloc(a, len + 1);
+  memcpy(p, str, len);
+  return p;
+}
+
+void sp_arena_free(sp_arena_t *a) {
+  sp_arena_block_t *b, *next;
+  for (b = a->head; b != NULL; b = next) {
+    next = b->next;
+    free(b);
+  }
+  memset(a, 0, sizeof(sp_arena_t));
+}
+
+#ifdef SPART_SHOW_PROFILE
+/* Prints the allocation counts of an arena */
+void sp_arena_profile(const char *name, const sp_arena_t *a) {
+  fprintf(stderr, "spart: arena %-6s %8u allocs %4u blocks %10zu bytes\n",
+          name, a->allocs, a->blocks, a->bytes);
+}
+#endif
+
+#endif /* SPART_SPART_ARENA_H_incl */
@@ -0,0 +1,171 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_BATCH_H_incl
+#define SPART_SPART_BATCH_H_incl
+
+#include <pwd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "spart.h"
+#include "spart_arena.h"
+#include "spart_data.h"
+#include "spart_hash.h"
+#include "spart_lib.h"
+#include "spart_string.h"
+#include "spart_user.h"
+
+/* The state of the --batch mode. The slurm data is loaded, and the
+ * partitions are computed once. The output of each user is made from a
+ * copy of them, with the job counts of the user. */
+typedef struct sp_batch {
+  /* the comma separated user names, or "all" for the users with jobs */
+  const char *list;
+  const char *dir;
+  sp_user_info_t *users;
+  uint32_t count;
+  /* the SPART_FETCH_ bits of the user info, which the partitions need */
+  uint16_t wanted;
+  /* the partitions without the job counts of a user */
+  sp_part_info_t *parts;
+  /* the users, their accounts and QOSs, and the partitions */
+  sp_arena_t arena;
+} sp_batch_t;
+
+/* Adds a user once. The groups are read later, for one user at a time. */
+void sp_batch_add(sp_batch_t *b, sp_hash_t *names, struct passwd *pw) {
+  sp_user_info_t *user = &(b->users[b->count]);
+  uint32_t *slot;
+
+  memset(user, 0, sizeof(sp_user_info_t));
+  sp_strn2cpy(user->user_name, SPART_INFO_STRING_SIZE, pw->pw_name,
+              SPART_INFO_STRING_SIZE);
+  slot = sp_hash_slot(names, user->user_name, strlen(user->user_name));
+  if (*slot != SPART_HASH_EMPTY) return;
+  *slot = b->count;
+  user->user_id = pw->pw_uid;
+  user->group_id = pw->pw_gid;
+  b->count++;
+}
+
+/* Reads the users of the batch. The unknown users are skipped. */
+void sp_batch_users(sp_batch_t *b, const sp_user_jobs_list_t *ujl) {
+  char name[SPART_INFO_STRING_SIZE];
+  const char *cursor = b->list;
+  const char *tok;
+  struct passwd *pw;
+  sp_hash_t names;
+  uint32_t i, len, size = 1;
+
+  if (strcmp(b->list, "all") == 0) {
+    size = ujl->count;
+  } else {
+    for (tok = b->list; *tok != '\0'; tok++)
+      if (*tok == ',') size++;
+  }
+  b->users = sp_arena_alloc(&(b->arena), (size + 1) * sizeof(sp_user_info_t));
+  b->count = 0;
+  sp_hash_init(&names, size);
+
+  if (strcmp(b->list, "all") == 0) {
+    /* the list is sorted by the users */
+    for (i = 0; i < ujl->count; i++) {
+      if ((i > 0) && (ujl->items[i].user_id == ujl->items[i - 1].user_id))
+        continue;
+      pw = getpwuid(ujl->items[i].user_id);
+      if (pw != NULL) sp_batch_add(b, &names, pw);
+    }
+  } else {
+    while ((tok = sp_token_next(&cursor, ',', &len)) != NULL) {
+      if ((len == 0) || (len >= SPART_INFO_STRING_SIZE)) continue;
+      memcpy(name, tok, len);
+      name[len] = '\0';
+      pw = getpwnam(name);
+      if (pw == NULL) {
+        fprintf(stderr, "Unknown user %s is skipped!\n", name);
+        continue;
+      }
+      sp_batch_add(b, &names, pw);
+    }
+  }
+  sp_hash_free(&names);
+}
+
+/* Prepares the batch from the computed partitions. The accounts and the
+ * QOSs of all users are read with one database query. Returns 0, or the
+ * slurm error number. */
+int sp_batch_load(sp_batch_t *b, sp_lib_t *lib, int all) {
+  uint32_t i;
+
+  sp_batch_users(b, lib->user_jobs);
+
+  /* the job counts of the calling user are not copied */
+  b->parts = sp_arena_alloc(&(b->arena),
+                            (lib->part_count + 1) * sizeof(sp_part_info_t));
+  memcpy(b->parts, lib->parts, lib->part_count * sizeof(sp_part_info_t));
+  for (i = 0; i < lib->part_count; i++) {
+    b->parts[i].my_running = 0;
+    b->parts[i].my_waiting_resource = 0;
+    b->parts[i].my_waiting_other = 0;
+    b->parts[i].my_total = 0;
+  }
+
+  if (all)
+    b->wanted = (1 << SPART_FETCH_ASSOC) | (1 << SPART_FETCH_GROUPS);
+  else
+    b->wanted = sp_parts_identity_needs(lib->parts, lib->part_count);
+  /* the identities are set for each user by sp_batch_select */
+  lib->identity_loaded = (1 << SPART_FETCH_ASSOC) | (1 << SPART_FETCH_GROUPS);
+  if ((b->wanted & (1 << SPART_FETCH_ASSOC)) && (b->count > 0))
+    return sp_user_assoc_get(&(b->arena), b->users, b->count);
+  return 0;
+}
+
+/* Makes the partitions of the kth user, and reads the user's groups if
+ * they are needed. Returns 0, or the error number of the groups. */
+int sp_batch_select(sp_batch_t *b, sp_lib_t *lib, uint32_t k) {
+  sp_user_info_t *user = &(b->users[k]);
+
+  memcpy(lib->parts, b->parts, lib->part_count * sizeof(sp_part_info_t));
+  sp_user_jobs_find(lib->parts, lib->part_count, lib->user_jobs->items,
+                    lib->user_jobs->count, user->user_id);
+  lib->fetch.user = user;
+  if (b->wanted & (1 << SPART_FETCH_GROUPS)) return sp_user_groups_get(user);
+  return 0;
+}
+
+/* Writes the output of the kth user to its file in the batch directory,
+ * and frees the user's groups and sets. If the file name is too long, the
+ * user is skipped. Returns 0 on error. */
+int sp_batch_write(sp_batch_t *b, uint32_t k, sp_strbuf_t *out) {
+  char path[SPART_INFO_STRING_SIZE];
+  int n, rc = 1;
+
+  n = snprintf(path, SPART_INFO_STRING_SIZE, "%s/%s", b->dir,
+               b->users[k].user_name);
+  if ((n < 0) || (n >= SPART_INFO_STRING_SIZE))
+    fprintf(stderr, "The output file name of %s is too long, skipped!\n",
+            b->users[k].user_name);
+  else
+    rc = sp_strbuf_save(out, path);
+  sp_strbuf_clear(out);
+  sp_user_free(&(b->users[k]));
+  return rc;
+}
+
+void sp_batch_free(sp_batch_t *b) {
+  uint32_t k;
+
+  for (k = 0; k < b->count; k++) sp_user_free(&(b->users[k]));
+  sp_arena_free(&(b->arena));
+  b->users = NULL;
+  b->parts = NULL;
+  b->count = 0;
+}
+
+#endif /* SPART_SPART_BATCH_H_incl */
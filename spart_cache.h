@@ -0,0 +1,414 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_CACHE_H_incl
+#define SPART_SPART_CACHE_H_incl
+
+#ifdef SPART_USE_SNAPSHOT
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "spart.h"
+#include "spart_string.h"
+
+/* The snapshot file starts with this magic and version. The version should
+ * be increased, if the snapshot or the server query format is changed. */
+#define SPART_SNAPSHOT_MAGIC "SPARTSNP"
+#define SPART_SNAPSHOT_VERSION 5
+
+/* To write a snapshot */
+typedef struct sp_snap_writer {
+  FILE *fo;
+  size_t offset;
+} sp_snap_writer_t;
+
+/* To read a snapshot from the memory map, with the bounds checks */
+typedef struct sp_snap_reader {
+  const char *start;
+  const char *pos;
+  const char *end;
+  int error;
+} sp_snap_reader_t;
+
+void sp_snap_put(sp_snap_writer_t *w, const void *p, size_t n) {
+  if (fwrite(p, 1, n, w->fo) != n) return;
+  w->offset += n;
+}
+
+void sp_snap_put_u16(sp_snap_writer_t *w, uint16_t v) {
+  sp_snap_put(w, &v, sizeof(v));
+}
+
+void sp_snap_put_u32(sp_snap_writer_t *w, uint32_t v) {
+  sp_snap_put(w, &v, sizeof(v));
+}
+
+void sp_snap_put_u64(sp_snap_writer_t *w, uint64_t v) {
+  sp_snap_put(w, &v, sizeof(v));
+}
+
+/* A string is saved as its length, chars and '\0'. NULL is saved as
+ * UINT32_MAX length. */
+void sp_snap_put_str(sp_snap_writer_t *w, const char *str) {
+  uint32_t len;
+  if (str == NULL) {
+    sp_snap_put_u32(w, UINT32_MAX);
+    return;
+  }
+  len = strlen(str);
+  sp_snap_put_u32(w, len);
+  sp_snap_put(w, str, len + 1);
+}
+
+/* Pads the file to the n byte boundary */
+void sp_snap_put_align(sp_snap_writer_t *w, size_t n) {
+  const char zero[8] = {0};
+  if (w->offset % n) sp_snap_put(w, zero, n - (w->offset % n));
+}
+
+const void *sp_snap_get(sp_snap_reader_t *r, size_t n) {
+  const char *p = r->pos;
+  if ((r->error) || ((size_t)(r->end - r->pos) < n)) {
+    r->error = 1;
+    return NULL;
+  }
+  r->pos += n;
+  return p;
+}
+
+uint16_t sp_snap_get_u16(sp_snap_reader_t *r) {
+  uint16_t v = 0;
+  const void *p = sp_snap_get(r, sizeof(v));
+  if (p != NULL) memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint32_t sp_snap_get_u32(sp_snap_reader_t *r) {
+  uint32_t v = 0;
+  const void *p = sp_snap_get(r, sizeof(v));
+  if (p != NULL) memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+uint64_t sp_snap_get_u64(sp_snap_reader_t *r) {
+  uint64_t v = 0;
+  const void *p = sp_snap_get(r, sizeof(v));
+  if (p != NULL) memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* Returns a pointer to the string in the memory map, without copying */
+char *sp_snap_get_str(sp_snap_reader_t *r) {
+  uint32_t len = sp_snap_get_u32(r);
+  const char *p;
+  if ((r->error) || (len == UINT32_MAX)) return NULL;
+  if (len > (uint32_t)(r->end - r->pos)) {
+    r->error = 1;
+    return NULL;
+  }
+  p = sp_snap_get(r, (size_t)len + 1);
+  if ((p == NULL) || (p[len] != '\0')) {
+    r->error = 1;
+    return NULL;
+  }
+  return (char *)p;
+}
+
+/* Reads a string offset, which should be in the string pool */
+uint32_t sp_snap_get_offset(sp_snap_reader_t *r, const sp_strpool_t *strs) {
+  uint32_t offset = sp_snap_get_u32(r);
+  if (offset >= strs->used) {
+    r->error = 1;
+    return 0;
+  }
+  return offset;
+}
+
+/* Copies a string of the snapshot to a fixed size member */
+void sp_snap_get_strcpy(sp_snap_reader_t *r, char *dest, size_t ndest) {
+  char *str = sp_snap_get_str(r);
+  dest[0] = 0;
+  if (str != NULL) {
+    sp_strn2cpy(dest, ndest, str, ndest);
+    dest[ndest - 1] = 0;
+  }
+}
+
+void sp_snap_get_align(sp_snap_reader_t *r, size_t n) {
+  size_t offset = r->pos - r->start;
+  if (offset % n) sp_snap_get(r, n - (offset % n));
+}
+
+/* Writes the user independent values of the partitions */
+void sp_snap_write_parts(sp_snap_writer_t *w, time_t created,
+                         uint16_t private_data, const char *cluster_name,
+                         sp_part_info_t *spData, uint32_t partition_count,
+                         const sp_strpool_t *strs) {
+  sp_part_info_t *sp;
+  uint32_t i;
+
+  sp_snap_put(w, SPART_SNAPSHOT_MAGIC, 8);
+  sp_snap_put_u32(w, SPART_SNAPSHOT_VERSION);
+  sp_snap_put_u32(w, sizeof(sp_user_jobs_t));
+  sp_snap_put_u64(w, (uint64_t)created);
+  sp_snap_put_u16(w, private_data);
+  sp_snap_put_str(w, cluster_name);
+  sp_snap_put_u32(w, partition_count);
+  /* the string pool is saved as is, the partitions keep the offsets */
+  sp_snap_put_u32(w, strs->used);
+  sp_snap_put(w, strs->data, strs->used);
+
+  for (i = 0; i < partition_count; i++) {
+    sp = &(spData[i]);
+    sp_snap_put_u32(w, sp->free_cpu);
+    sp_snap_put_u32(w, sp->total_cpu);
+    sp_snap_put_u32(w, sp->free_node);
+    sp_snap_put_u32(w, sp->total_node);
+    sp_snap_put_u32(w, sp->waiting_resource);
+    sp_snap_put_u32(w, sp->waiting_other);
+    sp_snap_put_u32(w, sp->min_nodes);
+    sp_snap_put_u32(w, sp->max_nodes);
+    sp_snap_put_u64(w, sp->def_mem_per_cpu);
+    sp_snap_put_u64(w, sp->max_mem_per_cpu);
+    sp_snap_put_u32(w, sp->max_cpus_per_node);
+    sp_snap_put_u32(w, sp->mjt_time);
+    sp_snap_put_u32(w, sp->djt_time);
+    sp_snap_put_u32(w, sp->min_core);
+    sp_snap_put_u32(w, sp->max_core);
+    sp_snap_put_u32(w, sp->min_mem_mb);
+    sp_snap_put_u32(w, sp->max_mem_mb);
+    sp_snap_put_u32(w, sp->flags);
+    sp_snap_put_u16(w, sp->state_up);
+    sp_snap_put_u16(w, sp->set_limits);
+    sp_snap_put_u32(w, sp->partition_name);
+    sp_snap_put_u32(w, sp->cluster_name);
+    sp_snap_put_u32(w, sp->partition_qos);
+    sp_snap_put_u32(w, sp->gres);
+    sp_snap_put_u32(w, sp->features);
+    sp_snap_put_u32(w, sp->allow_accounts);
+    sp_snap_put_u32(w, sp->deny_accounts);
+    sp_snap_put_u32(w, sp->allow_qos);
+    sp_snap_put_u32(w, sp->deny_qos);
+    sp_snap_put_u32(w, sp->allow_groups);
+  }
+}
+
+/* Writes the job counts of the users, after the partitions */
+void sp_snap_write_user_jobs(sp_snap_writer_t *w, sp_user_jobs_t *items,
+                             uint32_t count) {
+  sp_snap_put_u32(w, count);
+  sp_snap_put_align(w, sizeof(uint64_t));
+  sp_snap_put(w, items, count * sizeof(sp_user_jobs_t));
+}
+
+/* Parses a snapshot from the memory. Returns 1 on success. The string pool
+ * of the partitions is in the memory, so it should be kept. */
+int sp_snap_parse(sp_snapshot_t *snap, const char *buf, size_t size) {
+  sp_snap_reader_t r;
+  sp_part_info_t *sp;
+  uint32_t i;
+
+  r.start = buf;
+  r.pos = r.start;
+  r.end = r.start + size;
+  r.error = 0;
+
+  if ((size < 8) || (memcmp(sp_snap_get(&r, 8), SPART_SNAPSHOT_MAGIC, 8) != 0) ||
+      (sp_snap_get_u32(&r) != SPART_SNAPSHOT_VERSION) ||
+      (sp_snap_get_u32(&r) != sizeof(sp_user_jobs_t)))
+    return 0;
+  snap->created = (time_t)sp_snap_get_u64(&r);
+  snap->private_data = sp_snap_get_u16(&r);
+  sp_snap_get_strcpy(&r, snap->cluster_name, SPART_MAX_COLUMN_SIZE);
+  snap->partition_count = sp_snap_get_u32(&r);
+  /* each partition uses at least 100 bytes */
+  if ((r.error) || (snap->partition_count > size / 100)) return 0;
+  /* all strings should end in the pool */
+  snap->strings.used = sp_snap_get_u32(&r);
+  snap->strings.size = snap->strings.used;
+  snap->strings.data = (char *)sp_snap_get(&r, snap->strings.used);
+  if ((r.error) || (snap->strings.used == 0) ||
+      (snap->strings.data[0] != 0) ||
+      (snap->strings.data[snap->strings.used - 1] != 0))
+    return 0;
+
+  snap->spData = calloc(snap->partition_count + 1, sizeof(sp_part_info_t));
+  if (snap->spData == NULL) return 0;
+  for (i = 0; i < snap->partition_count; i++) {
+    sp = &(snap->spData[i]);
+    sp->visible = 1;
+    sp->free_cpu = sp_snap_get_u32(&r);
+    sp->total_cpu = sp_snap_get_u32(&r);
+    sp->free_node = sp_snap_get_u32(&r);
+    sp->total_node = sp_snap_get_u32(&r);
+    sp->waiting_resource = sp_snap_get_u32(&r);
+    sp->waiting_other = sp_snap_get_u32(&r);
+    sp->min_nodes = sp_snap_get_u32(&r);
+    sp->max_nodes = sp_snap_get_u32(&r);
+    sp->def_mem_per_cpu = sp_snap_get_u64(&r);
+    sp->max_mem_per_cpu = sp_snap_get_u64(&r);
+    sp->max_cpus_per_node = sp_snap_get_u32(&r);
+    sp->mjt_time = sp_snap_get_u32(&r);
+    sp->djt_time = sp_snap_get_u32(&r);
+    sp->min_core = sp_snap_get_u32(&r);
+    sp->max_core = sp_snap_get_u32(&r);
+    sp->min_mem_mb = sp_snap_get_u32(&r);
+    sp->max_mem_mb = sp_snap_get_u32(&r);
+    sp->flags = sp_snap_get_u32(&r);
+    sp->state_up = sp_snap_get_u16(&r);
+    sp->set_limits = sp_snap_get_u16(&r);
+    sp->partition_name = sp_snap_get_offset(&r, &(snap->strings));
+    sp->cluster_name = sp_snap_get_offset(&r, &(snap->strings));
+    sp->partition_qos = sp_snap_get_offset(&r, &(snap->strings));
+    sp->gres = sp_snap_get_offset(&r, &(snap->strings));
+    sp->features = sp_snap_get_offset(&r, &(snap->strings));
+    sp->allow_accounts = sp_snap_get_offset(&r, &(snap->strings));
+    sp->deny_accounts = sp_snap_get_offset(&r, &(snap->strings));
+    sp->allow_qos = sp_snap_get_offset(&r, &(snap->strings));
+    sp->deny_qos = sp_snap_get_offset(&r, &(snap->strings));
+    sp->allow_groups = sp_snap_get_offset(&r, &(snap->strings));
+  }
+
+  snap->user_jobs_count = sp_snap_get_u32(&r);
+  sp_snap_get_align(&r, sizeof(uint64_t));
+  if ((r.error) || (snap->user_jobs_count >
+                    (size_t)(r.end - r.pos) / sizeof(sp_user_jobs_t))) {
+    free(snap->spData);
+    snap->spData = NULL;
+    return 0;
+  }
+  snap->user_jobs = (sp_user_jobs_t *)r.pos;
+  return 1;
+}
+
+/* Maps an open snapshot file to the memory, and parses it. Returns 1 on
+ * success. The map is kept until the exit. */
+int sp_snap_map_fd(int fd, const struct stat *st, sp_snapshot_t *snap) {
+  memset(snap, 0, sizeof(sp_snapshot_t));
+  if (st->st_size < 8) return 0;
+  snap->size = st->st_size;
+  snap->map = mmap(NULL, snap->size, PROT_READ, MAP_SHARED, fd, 0);
+  if (snap->map == MAP_FAILED) {
+    snap->map = NULL;
+    return 0;
+  }
+  if (!sp_snap_parse(snap, snap->map, snap->size)) {
+    munmap(snap->map, snap->size);
+    memset(snap, 0, sizeof(sp_snapshot_t));
+    return 0;
+  }
+  return 1;
+}
+
+/* Maps a snapshot file to the memory, and parses it. Returns 1 on
+ * success. */
+int sp_snap_map(const char *path, sp_snapshot_t *snap) {
+  struct stat st;
+  int fd, rc = 0;
+
+  memset(snap, 0, sizeof(sp_snapshot_t));
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return 0;
+  if (fstat(fd, &st) == 0) rc = sp_snap_map_fd(fd, &st, snap);
+  close(fd);
+  return rc;
+}
+
+/* Frees a snapshot */
+void sp_snap_unmap(sp_snapshot_t *snap) {
+  free(snap->spData);
+  free(snap->buffer);
+  if (snap->map != NULL) munmap(snap->map, snap->size);
+  memset(snap, 0, sizeof(sp_snapshot_t));
+}
+
+#ifdef SPART_CACHE_DIR
+/* Returns the owner of the cache directory, or -1. Only the snapshots of
+ * this user are read, and only the spart calls of this user write them. */
+uid_t sp_cache_owner(void) {
+  struct stat st;
+
+  if ((stat(SPART_CACHE_DIR, &st) != 0) || (!S_ISDIR(st.st_mode)))
+    return (uid_t)-1;
+  return st.st_uid;
+}
+
+/* Writes the user independent partition values and the job counts of all
+ * users to a new file, then renames it to the snapshot path. The readers
+ * keep the map of the old file, so they do not need a lock. */
+void sp_cache_write(const char *path, time_t created, uint16_t private_data,
+                    const char *cluster_name, sp_part_info_t *spData,
+                    uint32_t partition_count, const sp_strpool_t *strs,
+                    sp_user_jobs_list_t *ujl) {
+  char tmp_path[SPART_INFO_STRING_SIZE + 16];
+  sp_snap_writer_t w;
+  int fd;
+
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0644);
+  if (fd < 0) return;
+  /* readable by all users, even if the umask is restrictive */
+  fchmod(fd, 0644);
+  w.fo = fdopen(fd, "w");
+  if (w.fo == NULL) {
+    close(fd);
+    unlink(tmp_path);
+    return;
+  }
+  w.offset = 0;
+
+  sp_snap_write_parts(&w, created, private_data, cluster_name, spData,
+                      partition_count, strs);
+  sp_snap_write_user_jobs(&w, ujl->items, ujl->count);
+
+  if ((fflush(w.fo) != 0) || ferror(w.fo)) {
+    fclose(w.fo);
+    unlink(tmp_path);
+    return;
+  }
+  fclose(w.fo);
+  if (rename(tmp_path, path) != 0) unlink(tmp_path);
+}
+
+/* Reads a snapshot which is younger than SPART_CACHE_TTL seconds. The
+ * snapshot should be a regular file of the owner of the cache directory,
+ * and the others should not be able to change it. Returns 1 on success. */
+int sp_cache_read(const char *path, sp_snapshot_t *snap) {
+  struct stat st;
+  time_t now = time(NULL);
+  uid_t owner = sp_cache_owner();
+  int fd, rc = 0;
+
+  memset(snap, 0, sizeof(sp_snapshot_t));
+  if (owner == (uid_t)-1) return 0;
+  fd = open(path, O_RDONLY | O_NOFOLLOW);
+  if (fd < 0) return 0;
+  if ((fstat(fd, &st) == 0) && (S_ISREG(st.st_mode)) &&
+      (st.st_uid == owner) && (!(st.st_mode & (S_IWGRP | S_IWOTH))) &&
+      (st.st_mtime + SPART_CACHE_TTL >= now))
+    rc = sp_snap_map_fd(fd, &st, snap);
+  close(fd);
+  if (!rc) return 0;
+  if ((snap->created + SPART_CACHE_TTL < now) || (snap->created > now + 1)) {
+    sp_snap_unmap(snap);
+    return 0;
+  }
+  return 1;
+}
+
+#endif /* SPART_CACHE_DIR */
+
+#endif /* SPART_USE_SNAPSHOT */
+
+#endif /* SPART_SPART_CACHE_H_incl */
@@ -8,72 +8,459 @@
 #ifndef SPART_SPART_DATA_H_incl
 #define SPART_SPART_DATA_H_incl
 
+#include <limits.h>
+#include "spart.h"
+#include "spart_hash.h"
 #include "spart_string.h"
 
-/* Add one gres to partition gres list */
-void sp_gres_add(sp_gres_info_t spga[], uint16_t *sp_gres_count,
-                 char *node_gres) {
-  uint16_t i;
-  int found = 0;
-  char *strtmp = NULL;
-  char *grestok;
-
-  for (grestok = strtok_r(node_gres, ",", &strtmp); grestok != NULL;
-       grestok = strtok_r(NULL, ",", &strtmp)) {
-    for (i = 0; i < *sp_gres_count; i++) {
-      if (strncmp(spga[i].gres_name, grestok, SPART_INFO_STRING_SIZE) == 0) {
-        spga[i].count++;
-        found = 1;
-        break;
+void sp_tokens_init(sp_tokens_t *t, uint32_t node_count) {
+  memset(t, 0, sizeof(sp_tokens_t));
+  sp_hash_init(&(t->index), 64);
+  t->nodes = calloc(node_count + 1, sizeof(sp_node_tokens_t));
+  if (t->nodes == NULL) {
+    slurm_perror("Can not allocate gres list");
+    exit(1);
+  }
+}
+
+void sp_tokens_free(sp_tokens_t *t) {
+  sp_hash_free(&(t->index));
+  free(t->names);
+  free(t->lens);
+  free(t->order);
+  free(t->counts);
+  free(t->nodes);
+  free(t->ids);
+  memset(t, 0, sizeof(sp_tokens_t));
+}
+
+/* Returns the id of a token, a new token gets the next id */
+uint32_t sp_tokens_id(sp_tokens_t *t, const char *tok, uint32_t len) {
+  uint32_t *slot = sp_hash_slot(&(t->index), tok, len);
+
+  if (*slot != SPART_HASH_EMPTY) return *slot;
+  if (t->count == t->size) {
+    t->size = (t->size == 0) ? 64 : t->size * 2;
+    t->names = realloc(t->names, t->size * sizeof(char *));
+    t->lens = realloc(t->lens, t->size * sizeof(uint32_t));
+    t->order = realloc(t->order, t->size * sizeof(uint32_t));
+    t->counts = realloc(t->counts, t->size * sizeof(uint32_t));
+    if ((t->names == NULL) || (t->lens == NULL) || (t->order == NULL) ||
+        (t->counts == NULL)) {
+      slurm_perror("Can not allocate gres list");
+      exit(1);
+    }
+  }
+  t->names[t->count] = tok;
+  t->lens[t->count] = len;
+  t->counts[t->count] = 0;
+  *slot = t->count;
+  return t->count++;
+}
+
+/* Parses the comma seperated gres/features list of a node to the token
+ * ids. The list is not modified. */
+void sp_tokens_parse(sp_tokens_t *t, sp_node_tokens_t *nt, const char *list) {
+  const char *cursor = list;
+  const char *tok;
+  uint32_t len;
+
+  nt->first = t->ids_used;
+  nt->count = 0;
+  nt->parsed = 1;
+  if (list == NULL) return;
+  while ((tok = sp_token_next(&cursor, ',', &len)) != NULL) {
+    if (t->ids_used == t->ids_size) {
+      t->ids_size = (t->ids_size == 0) ? 256 : t->ids_size * 2;
+      t->ids = realloc(t->ids, t->ids_size * sizeof(uint32_t));
+      if (t->ids == NULL) {
+        slurm_perror("Can not allocate gres list");
+        exit(1);
       }
     }
+    t->ids[t->ids_used++] = sp_tokens_id(t, tok, len);
+    nt->count++;
+  }
+}
+
+/* Counts the tokens of a node for the current partition. The list of the
+ * node is parsed only at the first call for the node. */
+void sp_tokens_add(sp_tokens_t *t, uint32_t node, const char *list) {
+  sp_node_tokens_t *nt = &(t->nodes[node]);
+  uint32_t j, id;
+
+  if (!nt->parsed) sp_tokens_parse(t, nt, list);
+  for (j = nt->first; j < nt->first + nt->count; j++) {
+    id = t->ids[j];
+    if (t->counts[id]++ == 0) t->order[t->used++] = id;
+  }
+}
+
+/* Adds the tokens of the current partition to the string pool as the
+ * "name(count),..." string, and returns its offset. The counts are reset
+ * for the next partition. */
+uint32_t sp_tokens_to_str(sp_tokens_t *t, sp_strpool_t *strs) {
+  uint32_t j, id;
+  uint32_t start = strs->used;
+  char strtmp[SPART_MAX_COLUMN_SIZE];
+
+  if (t->used == 0) return sp_strpool_add(strs, "-");
+  for (j = 0; j < t->used; j++) {
+    id = t->order[j];
+    if (j > 0) sp_strpool_cat(strs, ",", 1);
+    sp_strpool_cat(strs, t->names[id], t->lens[id]);
+    sp_con_strprint(strtmp, SPART_MAX_COLUMN_SIZE, t->counts[id]);
+    sp_strpool_cat(strs, "(", 1);
+    sp_strpool_cat(strs, strtmp, strlen(strtmp));
+    sp_strpool_cat(strs, ")", 1);
+    t->counts[id] = 0;
+  }
+  t->used = 0;
+  return sp_strpool_end(strs, start);
+}
+
+/* Returns the allocated cores of a node, from the select plugin */
+uint16_t sp_node_alloc_cpus(node_info_t *node) {
+  uint16_t alloc_cpus = 0;
+  slurm_get_select_nodeinfo(node->select_nodeinfo, SELECT_NODEDATA_SUBCNT,
+                            NODE_STATE_ALLOCATED, &alloc_cpus);
+  return alloc_cpus;
+}
+
+/* Reads the values of a node, which are used by the partitions. If
+ * alloc_cpus is not NULL, the allocated cores are read from it, instead of
+ * the select plugin. */
+void sp_node_read(sp_node_info_t *spn, node_info_t *node,
+                  const uint16_t *alloc_cpus) {
+  uint32_t state;
+#ifdef SPART_COMPILE_FOR_UHEM
+  char *reason;
+#endif
+
+  spn->cpus = node->cpus;
+  spn->mem = (uint32_t)(node->real_memory);
+  spn->alloc_cpus =
+      (alloc_cpus != NULL) ? *alloc_cpus : sp_node_alloc_cpus(node);
+
+  state = node->node_state;
+#ifdef SPART_COMPILE_FOR_UHEM
+  reason = node->reason;
+#endif
+
+  /* The PowerSave_PwrOffState and PwrON_State_PowerSave control
+   * for an alternative power saving solution we developed.
+   * It required for showing power-off nodes as idle */
+  spn->usable = ((((state & NODE_STATE_DRAIN) != NODE_STATE_DRAIN) &&
+                  ((state & NODE_STATE_BASE) != NODE_STATE_DOWN) &&
+                  (state != NODE_STATE_UNKNOWN))
+#ifdef SPART_COMPILE_FOR_UHEM
+                 ||
+                 (strncmp(reason, "PowerSave_PwrOffState", 21) == 0) ||
+                 (strncmp(reason, "PwrON_State_PowerSave", 21) == 0)
+#endif
+  );
+}
+
+/* Reads the values of the nodes which are used by the selected partitions.
+ * If selected is NULL, all nodes are read. If alloc_cpus is not NULL, it
+ * has the allocated cores of each node. */
+sp_node_info_t *sp_nodes_read(sp_arena_t *arena,
+                              node_info_msg_t *node_buffer_ptr,
+                              partition_info_msg_t *part_buffer_ptr,
+                              uint8_t *selected, const uint16_t *alloc_cpus) {
+  uint32_t i, j;
+  int k;
+  partition_info_t *part_ptr;
+  sp_node_info_t *spn;
+
+  spn = sp_arena_alloc(arena, (node_buffer_ptr->record_count + 1) *
+                                  sizeof(sp_node_info_t));
+
+  if (selected == NULL) {
+    for (i = 0; i < node_buffer_ptr->record_count; i++)
+      sp_node_read(&(spn[i]), &(node_buffer_ptr->node_array[i]),
+                   (alloc_cpus != NULL) ? &(alloc_cpus[i]) : NULL);
+    return spn;
+  }
+
+  for (i = 0; i < part_buffer_ptr->record_count; i++) {
+    if (!selected[i]) continue;
+    part_ptr = &(part_buffer_ptr->partition_array[i]);
+    for (j = 0; part_ptr->node_inx; j += 2) {
+      if (part_ptr->node_inx[j] == -1) break;
+      for (k = part_ptr->node_inx[j]; k <= part_ptr->node_inx[j + 1]; k++)
+        sp_node_read(&(spn[k]), &(node_buffer_ptr->node_array[k]),
+                     (alloc_cpus != NULL) ? &(alloc_cpus[k]) : NULL);
+    }
+  }
+  return spn;
+}
+
+/* Adds the names of a comma seperated list to a hash set. The names are
+ * not copied, the list should live as long as the set. */
+void sp_names_set_build(sp_hash_t *set, const char *list) {
+  const char *cursor = list;
+  const char *tok;
+  uint32_t len;
+
+  sp_hash_init(set, 8);
+  while ((tok = sp_token_next(&cursor, ',', &len)) != NULL)
+    *sp_hash_slot(set, tok, len) = 1;
+}
+
+/* Is the name in the hash set */
+int sp_names_set_has(const sp_hash_t *set, const char *name) {
+  if (name == NULL) return 0;
+  return sp_hash_get(set, name, strlen(name)) != SPART_HASH_EMPTY;
+}
+
+/* Returns the selected flags of the partitions, which are in the set */
+uint8_t *sp_parts_select(sp_arena_t *arena,
+                         partition_info_msg_t *part_buffer_ptr,
+                         const sp_hash_t *set) {
+  uint32_t i;
+  uint8_t *selected;
+
+  selected = sp_arena_alloc(arena, part_buffer_ptr->record_count + 1);
+  for (i = 0; i < part_buffer_ptr->record_count; i++)
+    selected[i] =
+        sp_names_set_has(set, part_buffer_ptr->partition_array[i].name);
+  return selected;
+}
+
+/* Builds the partition name index. If selected is not NULL, only the
+ * selected partitions are indexed, so the jobs of the others are not
+ * counted. */
+void sp_part_index_build(sp_part_index_t *spi,
+                         partition_info_msg_t *part_buffer_ptr,
+                         uint8_t *selected) {
+  uint32_t i, n = part_buffer_ptr->record_count;
+  uint32_t *slot;
+  char *name;
+
+  sp_hash_init(&(spi->names), n);
+  spi->next = malloc((n + 1) * sizeof(uint32_t));
+  spi->last_job = malloc((n + 1) * sizeof(uint32_t));
+  if ((spi->next == NULL) || (spi->last_job == NULL)) {
+    slurm_perror("Can not allocate partition index");
+    exit(1);
+  }
+  /* reverse order keeps the chains in the partition order */
+  for (i = n; i > 0; i--) {
+    name = part_buffer_ptr->partition_array[i - 1].name;
+    spi->last_job[i - 1] = SPART_HASH_EMPTY;
+    if ((name == NULL) || ((selected != NULL) && (!selected[i - 1])))
+      continue;
+    slot = sp_hash_slot(&(spi->names), name, strlen(name));
+    spi->next[i - 1] = *slot;
+    *slot = i - 1;
+  }
+}
+
+void sp_part_index_free(sp_part_index_t *spi) {
+  sp_hash_free(&(spi->names));
+  free(spi->next);
+  free(spi->last_job);
+}
+
+/* Is the job waiting for the busy resources */
+int sp_job_waits_resource(slurm_job_info_t *job) {
+  return ((job->state_reason == WAIT_RESOURCES) ||
+          (job->state_reason == WAIT_NODE_NOT_AVAIL) ||
+          (job->state_reason == WAIT_PRIORITY));
+}
+
+/* Adds a job to the job counts of its user */
+void sp_user_job_count(sp_user_jobs_t *uj, slurm_job_info_t *job) {
+  if (job->job_state == JOB_PENDING) {
+    if (sp_job_waits_resource(job))
+      uj->waiting_resource++;
+    else
+      uj->waiting_other++;
+  } else {
+    if (job->job_state == JOB_RUNNING) uj->running++;
+  }
+  if ((job->job_state == JOB_PENDING) || (job->job_state == JOB_RUNNING) ||
+      (job->job_state == JOB_SUSPENDED))
+    uj->total++;
+}
+
+/* Adds the user job counts to the my_xxx counts of a partition */
+void sp_user_jobs_apply(sp_part_info_t *sp, sp_user_jobs_t *uj) {
+  sp->my_running += uj->running;
+  sp->my_waiting_resource += uj->waiting_resource;
+  sp->my_waiting_other += uj->waiting_other;
+  sp->my_total += uj->total;
+}
+
+/* Adds a job to the user job count list */
+void sp_user_jobs_add(sp_user_jobs_list_t *ujl, slurm_job_info_t *job,
+                      uint32_t partition) {
+  sp_user_jobs_t *uj;
+
+  if (ujl->count == ujl->size) {
+    ujl->size = (ujl->size == 0) ? 1024 : ujl->size * 2;
+    ujl->items = realloc(ujl->items, ujl->size * sizeof(sp_user_jobs_t));
+    if (ujl->items == NULL) {
+      slurm_perror("Can not allocate user job list");
+      exit(1);
+    }
+  }
+  uj = &(ujl->items[ujl->count]);
+  memset(uj, 0, sizeof(sp_user_jobs_t));
+  uj->user_id = job->user_id;
+  uj->partition = partition;
+  sp_user_job_count(uj, job);
+  if (uj->total) ujl->count++;
+}
+
+int sp_user_jobs_compare(const void *a, const void *b) {
+  const sp_user_jobs_t *x = a;
+  const sp_user_jobs_t *y = b;
+  if (x->user_id != y->user_id) return (x->user_id < y->user_id) ? -1 : 1;
+  if (x->partition != y->partition)
+    return (x->partition < y->partition) ? -1 : 1;
+  return 0;
+}
+
+/* Sorts the list by the user and the partition, and merges the counts of
+ * the same user and partition */
+void sp_user_jobs_merge(sp_user_jobs_list_t *ujl) {
+  uint32_t i, n = 0;
+
+  if (ujl->count == 0) return;
+  qsort(ujl->items, ujl->count, sizeof(sp_user_jobs_t), sp_user_jobs_compare);
+  for (i = 1; i < ujl->count; i++) {
+    if (sp_user_jobs_compare(&(ujl->items[n]), &(ujl->items[i])) == 0) {
+      ujl->items[n].running += ujl->items[i].running;
+      ujl->items[n].waiting_resource += ujl->items[i].waiting_resource;
+      ujl->items[n].waiting_other += ujl->items[i].waiting_other;
+      ujl->items[n].total += ujl->items[i].total;
+    } else {
+      n++;
+      ujl->items[n] = ujl->items[i];
+    }
+  }
+  ujl->count = n + 1;
+}
+
+/* Adds a job to the waiting and the user's job counts of a partition */
+void sp_job_count(sp_part_info_t *sp, slurm_job_info_t *job, int user_id) {
+  sp_user_jobs_t uj;
+
+  if (job->job_state == JOB_PENDING) {
+    if (sp_job_waits_resource(job))
+      sp->waiting_resource += job->num_cpus;
+    else
+      sp->waiting_other += job->num_cpus;
+  }
+  if (job->user_id == user_id) {
+    memset(&uj, 0, sizeof(sp_user_jobs_t));
+    sp_user_job_count(&uj, job);
+    sp_user_jobs_apply(sp, &uj);
+  }
+}
 
-    if (found == 0) {
-      sp_strn2cpy(spga[*sp_gres_count].gres_name, SPART_INFO_STRING_SIZE,
-                  grestok, SPART_INFO_STRING_SIZE);
-      spga[*sp_gres_count].count = 1;
-      (*sp_gres_count)++;
+/* Counts each job for each partition in its comma seperated partition
+ * list, using the partition name index. If ujl is not NULL, the job counts
+ * of all users are also collected to it. */
+void sp_jobs_count(sp_part_info_t *spData, sp_part_index_t *spi,
+                   job_info_msg_t *job_buffer_ptr, int user_id,
+                   sp_user_jobs_list_t *ujl) {
+  uint32_t i, j, len;
+  const char *cursor;
+  const char *tok;
+  slurm_job_info_t *job;
+
+  for (i = 0; i < job_buffer_ptr->record_count; i++) {
+    job = &(job_buffer_ptr->job_array[i]);
+    cursor = job->partition;
+    while ((tok = sp_token_next(&cursor, ',', &len)) != NULL) {
+      for (j = sp_hash_get(&(spi->names), tok, len); j != SPART_HASH_EMPTY;
+           j = spi->next[j]) {
+        /* a partition can be repeated in the job partition list */
+        if (spi->last_job[j] == i) continue;
+        spi->last_job[j] = i;
+        sp_job_count(&(spData[j]), job, user_id);
+        if (ujl != NULL) sp_user_jobs_add(ujl, job, j);
+      }
     }
   }
+  if (ujl != NULL) sp_user_jobs_merge(ujl);
+}
+
+/* Returns the first item of the user in a sorted user job count list */
+uint32_t sp_user_jobs_first(sp_user_jobs_t *items, uint32_t count,
+                            uint32_t user_id) {
+  uint32_t lo = 0, hi = count, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (items[mid].user_id < user_id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
 }
 
-/* Sets all counts as zero in the partition gres list */
-void sp_gres_reset_counts(sp_gres_info_t *spga, uint16_t *sp_gres_count) {
-  uint16_t i;
-  for (i = 0; i < *sp_gres_count; i++) {
-    spga[i].count = 0;
+/* Adds the job counts of the user from a sorted user job count list */
+void sp_user_jobs_find(sp_part_info_t *spData, uint32_t partition_count,
+                       sp_user_jobs_t *items, uint32_t count,
+                       uint32_t user_id) {
+  uint32_t i;
+
+  for (i = sp_user_jobs_first(items, count, user_id);
+       (i < count) && (items[i].user_id == user_id); i++)
+    if (items[i].partition < partition_count)
+      sp_user_jobs_apply(&(spData[items[i].partition]), &(items[i]));
+}
+
+/* Returns how many names of the set are in a comma seperated access list.
+ * The list is scanned without a copy, and the result is kept for the
+ * other partitions which have the same list. */
+uint32_t sp_user_set_count(sp_user_set_t *set, const char *list) {
+  const char *cursor = list;
+  const char *tok;
+  uint32_t len, id, found = 0;
+  uint32_t *result;
+
+  if (set->count == 0) return 0;
+  result = sp_hash_slot(&(set->results), list, strlen(list));
+  if (*result != SPART_HASH_EMPTY) return *result;
+
+  set->stamp++;
+  while ((tok = sp_token_next(&cursor, ',', &len)) != NULL) {
+    id = sp_hash_get(&(set->names), tok, len);
+    if ((id != SPART_HASH_EMPTY) && (set->seen[id] != set->stamp)) {
+      set->seen[id] = set->stamp;
+      found++;
+    }
   }
-  (*sp_gres_count) = 0;
+  *result = found;
+  return found;
 }
 
-/* it checks for permision string for user_spec list, return 0 if partition
+/* it checks for permision string for user set, return 0 if partition
  * should be hide */
-int sp_check_permision_set_legend(char *permisions, char **user_spec,
-                                  int user_spec_count, char *legendstr,
-                                  const char *r_all, const char *r_some,
-                                  const char *r_none) {
-  int found_count;
-  // char strtmp[SPART_INFO_STRING_SIZE];
-  char *strtmp;
-  int nstrtmp;
+int sp_check_permision_set_legend(const char *permisions, sp_user_set_t *set,
+                                  char *legendstr, const char *r_all,
+                                  const char *r_some, const char *r_none) {
+  uint32_t found_count;
 
   if (permisions != NULL) {
-    nstrtmp = strlen(permisions);
-    if (nstrtmp != 0) {
-      strtmp = malloc(nstrtmp * sizeof(char));
-      sp_strn2cpy(strtmp, nstrtmp, permisions, nstrtmp);
-      found_count = sp_account_check(user_spec, user_spec_count, strtmp);
-      free(strtmp);
+    if (permisions[0] != 0) {
+      found_count = sp_user_set_count(set, permisions);
       if (found_count) {
         /* more than zero in the list */
-        if (found_count != user_spec_count) {
+        if (found_count != set->count) {
           /* partial match */
-          sp_strn2cat(legendstr, SPART_MAX_COLUMN_SIZE, r_some, 2);
+          sp_strn2cat(legendstr, SPART_STATUS_SIZE, r_some, 2);
         } else {
           /* found_count = ALL */
           if (r_all != NULL) {
             /* this is an deny list */
-            sp_strn2cat(legendstr, SPART_MAX_COLUMN_SIZE, r_all, 2);
+            sp_strn2cat(legendstr, SPART_STATUS_SIZE, r_all, 2);
             return 0;
           }
         }
@@ -81,7 +468,7 @@ int sp_check_permision_set_legend(char *permisions, char **user_spec,
         /* found_count = 0 */
         if (r_none != NULL) {
           /* this is an allow list */
-          sp_strn2cat(legendstr, SPART_MAX_COLUMN_SIZE, r_none, 2);
+          sp_strn2cat(legendstr, SPART_STATUS_SIZE, r_none, 2);
           return 0;
         }
       }
@@ -90,4 +477,296 @@ int sp_check_permision_set_legend(char *permisions, char **user_spec,
   return 1;
 }
 
+/* Fills the user independent values of each partition. The gres and the
+ * features are only collected if they will be shown. The strings are
+ * added to strs. */
+sp_part_info_t *sp_parts_read(sp_arena_t *arena,
+                              partition_info_msg_t *part_buffer_ptr,
+                              node_info_msg_t *node_buffer_ptr,
+                              sp_node_info_t *spNodes,
+                              const char *cluster_name, uint16_t compute,
+                              uint8_t *selected, sp_strpool_t *strs) {
+  uint32_t i, j;
+  int k;
+  uint32_t mem, cpus, min_mem, max_mem;
+  uint32_t max_cpu, min_cpu, free_cpu, free_node;
+  uint64_t max_mem_per_cpu = 0;
+  uint64_t def_mem_per_cpu = 0;
+  /* These values are default/unsetted values */
+  const uint32_t default_min_nodes = 0, default_max_nodes = UINT_MAX;
+  const uint64_t default_max_mem_per_cpu = 0;
+  const uint64_t default_def_mem_per_cpu = 0;
+  const uint32_t default_max_cpus_per_node = UINT_MAX;
+  const uint32_t default_mjt_time = INFINITE;
+  char *default_qos = "normal";
+
+  uint32_t partition_count = part_buffer_ptr->record_count;
+  partition_info_t *part_ptr = NULL;
+  sp_part_info_t *spData = NULL;
+
+  uint32_t node_count;
+  sp_tokens_t spgres;
+  sp_tokens_t spfeatures;
+
+  spData =
+      sp_arena_alloc(arena, (partition_count + 1) * sizeof(sp_part_info_t));
+
+  /* the tokens are shared by all partitions */
+  node_count = (node_buffer_ptr != NULL) ? node_buffer_ptr->record_count : 0;
+  sp_tokens_init(&spgres, node_count);
+  sp_tokens_init(&spfeatures, node_count);
+
+  for (i = 0; i < partition_count; i++) {
+    part_ptr = &part_buffer_ptr->partition_array[i];
+    spData[i].visible = 1;
+
+    min_mem = UINT_MAX;
+    max_mem = 0;
+    min_cpu = UINT_MAX;
+    max_cpu = 0;
+    free_cpu = 0;
+    free_node = 0;
+
+    /* the nodes are not loaded, if no column needs them. The nodes of the
+     * partitions, which are not selected, are not read. */
+    for (j = 0; (spNodes != NULL) && (part_ptr->node_inx) &&
+                ((selected == NULL) || (selected[i]));
+         j += 2) {
+      if (part_ptr->node_inx[j] == -1) break;
+      for (k = part_ptr->node_inx[j]; k <= part_ptr->node_inx[j + 1]; k++) {
+        cpus = spNodes[k].cpus;
+        if (compute & SPART_PLAN_NODE_LIMITS) {
+          mem = spNodes[k].mem;
+          if (min_mem > mem) min_mem = mem;
+          if (max_mem < mem) max_mem = mem;
+          if (min_cpu > cpus) min_cpu = cpus;
+          if (max_cpu < cpus) max_cpu = cpus;
+        }
+
+        /* If gres will not show, don't run */
+        if (compute & SPART_PLAN_GRES)
+          sp_tokens_add(&spgres, k, node_buffer_ptr->node_array[k].gres);
+
+        /* If features will not show, don't run */
+        if (compute & SPART_PLAN_FEATURES) {
+          if (node_buffer_ptr->node_array[k].features_act != NULL)
+            sp_tokens_add(&spfeatures, k,
+                          node_buffer_ptr->node_array[k].features_act);
+          else
+            sp_tokens_add(&spfeatures, k,
+                          node_buffer_ptr->node_array[k].features);
+        }
+
+        if (spNodes[k].usable) {
+          if (spNodes[k].alloc_cpus == 0) free_node += 1;
+          free_cpu += cpus - spNodes[k].alloc_cpus;
+        }
+      }
+    }
+
+#ifdef __slurmdb_cluster_rec_t_defined
+    if (part_ptr->cluster_name != NULL)
+      spData[i].cluster_name = sp_strpool_add(strs, part_ptr->cluster_name);
+    else
+      spData[i].cluster_name = sp_strpool_add(strs, cluster_name);
+#endif
+
+    spData[i].flags = part_ptr->flags;
+    spData[i].state_up = part_ptr->state_up;
+    spData[i].allow_accounts = sp_strpool_add(strs, part_ptr->allow_accounts);
+    spData[i].deny_accounts = sp_strpool_add(strs, part_ptr->deny_accounts);
+    spData[i].allow_qos = sp_strpool_add(strs, part_ptr->allow_qos);
+    spData[i].deny_qos = sp_strpool_add(strs, part_ptr->deny_qos);
+    spData[i].allow_groups = sp_strpool_add(strs, part_ptr->allow_groups);
+
+    /* spgres (GRES) data converting to string */
+    spData[i].gres = sp_tokens_to_str(&spgres, strs);
+    /* spfeatures data converting to string */
+    spData[i].features = sp_tokens_to_str(&spfeatures, strs);
+
+    spData[i].free_cpu = free_cpu;
+    spData[i].total_cpu = part_ptr->total_cpus;
+    spData[i].free_node = free_node;
+    spData[i].total_node = part_ptr->total_nodes;
+
+    spData[i].min_nodes = part_ptr->min_nodes;
+    if (part_ptr->min_nodes != default_min_nodes)
+      spData[i].set_limits |= SPART_SET_MIN_NODES;
+    spData[i].max_nodes = part_ptr->max_nodes;
+    if (part_ptr->max_nodes != default_max_nodes)
+      spData[i].set_limits |= SPART_SET_MAX_NODES;
+    spData[i].max_cpus_per_node = part_ptr->max_cpus_per_node;
+    if ((part_ptr->max_cpus_per_node != default_max_cpus_per_node) &&
+        (part_ptr->max_cpus_per_node != 0))
+      spData[i].set_limits |= SPART_SET_MAX_CPUS_PER_NODE;
+
+    /* the def_mem_per_cpu and max_mem_per_cpu members contains
+     * both FLAG bit (MEM_PER_CPU) for CPU/NODE selection, and values. */
+    def_mem_per_cpu = part_ptr->def_mem_per_cpu;
+    if (def_mem_per_cpu & MEM_PER_CPU) {
+      spData[i].set_limits |= SPART_DEF_MEM_IS_PER_CPU;
+      def_mem_per_cpu = def_mem_per_cpu & (~MEM_PER_CPU);
+    }
+    spData[i].def_mem_per_cpu = def_mem_per_cpu;
+    if (def_mem_per_cpu != default_def_mem_per_cpu)
+      spData[i].set_limits |= SPART_SET_DEF_MEM_PER_CPU;
+
+    max_mem_per_cpu = part_ptr->max_mem_per_cpu;
+    if (max_mem_per_cpu & MEM_PER_CPU) {
+      spData[i].set_limits |= SPART_MAX_MEM_IS_PER_CPU;
+      max_mem_per_cpu = max_mem_per_cpu & (~MEM_PER_CPU);
+    }
+    spData[i].max_mem_per_cpu = max_mem_per_cpu;
+    if (max_mem_per_cpu != default_max_mem_per_cpu)
+      spData[i].set_limits |= SPART_SET_MAX_MEM_PER_CPU;
+
+    spData[i].mjt_time = part_ptr->max_time;
+    if (part_ptr->max_time != default_mjt_time)
+      spData[i].set_limits |= SPART_SET_MJT_TIME;
+    spData[i].djt_time = part_ptr->default_time;
+    if ((part_ptr->default_time != default_mjt_time) &&
+        (part_ptr->default_time != NO_VAL) &&
+        (part_ptr->default_time != part_ptr->max_time))
+      spData[i].set_limits |= SPART_SET_DJT_TIME;
+    spData[i].min_core = min_cpu;
+    spData[i].max_core = max_cpu;
+    spData[i].max_mem_mb = max_mem;
+    spData[i].min_mem_mb = min_mem;
+
+    if (!(compute & SPART_PLAN_QOS)) {
+      spData[i].partition_qos = 0;
+    } else if ((part_ptr->qos_char != NULL) &&
+               (strlen(part_ptr->qos_char) > 0)) {
+      spData[i].partition_qos = sp_strpool_add(strs, part_ptr->qos_char);
+      if (strncmp(part_ptr->qos_char, default_qos, SPART_MAX_COLUMN_SIZE) != 0)
+        spData[i].set_limits |= SPART_SET_PARTITION_QOS;
+    } else
+      spData[i].partition_qos = sp_strpool_add(strs, "-");
+
+    spData[i].partition_name = sp_strpool_add(strs, part_ptr->name);
+  }
+  sp_tokens_free(&spgres);
+  sp_tokens_free(&spfeatures);
+  return spData;
+}
+
+/* Sets the slurm requests, which are needed by the computations */
+void sp_plan_set_wanted(sp_plan_t *plan) {
+  plan->wanted = (1 << SPART_FETCH_CONF) | (1 << SPART_FETCH_PARTITIONS);
+  if (plan->compute & (SPART_PLAN_MY_JOBS | SPART_PLAN_WAITING))
+    plan->wanted |= (1 << SPART_FETCH_JOBS);
+  if (plan->compute & (SPART_PLAN_NODES | SPART_PLAN_NODE_LIMITS |
+                       SPART_PLAN_GRES | SPART_PLAN_FEATURES))
+    plan->wanted |= (1 << SPART_FETCH_NODES);
+}
+
+/* Returns the SPART_FETCH_ bits of the user info, which is needed to check
+ * the access lists of the partitions. */
+uint16_t sp_parts_identity_needs(sp_part_info_t *spData,
+                                 uint32_t partition_count) {
+  uint16_t wanted = 0;
+#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
+  uint32_t i;
+
+  for (i = 0; i < partition_count; i++) {
+    /* the empty strings are at the offset 0 */
+    if (spData[i].allow_accounts || spData[i].deny_accounts ||
+        spData[i].allow_qos || spData[i].deny_qos)
+      wanted |= (1 << SPART_FETCH_ASSOC);
+    if (spData[i].allow_groups) wanted |= (1 << SPART_FETCH_GROUPS);
+  }
+#endif
+  return wanted;
+}
+
+/* Sets the partition_status legends and the visibility of a partition for
+ * the user. Returns 0, if the slurm would not list this partition to the
+ * user without SHOW_ALL (hidden, or closed to all groups of the user). */
+int sp_part_set_status(sp_part_info_t *sp, const sp_strpool_t *strs,
+                       sp_user_info_t *user, int show_all_partition) {
+#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
+  int k;
+#endif
+  int listed = 1;
+
+  sp->partition_status[0] = 0;
+  sp->visible = 1;
+
+  /* Partition States from more important to less important
+   *  because, there is limited space. */
+  if (sp->flags & PART_FLAG_DEFAULT)
+    sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "*", 2);
+  if (sp->flags & PART_FLAG_HIDDEN) {
+    sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, ".", 2);
+    listed = 0;
+  }
+
+#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
+
+  k = sp_check_permision_set_legend(sp_str(strs, sp->allow_accounts),
+                                    &(user->acct_set), sp->partition_status,
+                                    NULL, "a", "A");
+  if ((!show_all_partition) && (k == 0)) sp->visible = 0;
+
+  k = sp_check_permision_set_legend(sp_str(strs, sp->deny_accounts),
+                                    &(user->acct_set), sp->partition_status,
+                                    "A", "a", NULL);
+  if ((!show_all_partition) && (k == 0)) sp->visible = 0;
+
+  k = sp_check_permision_set_legend(sp_str(strs, sp->allow_qos),
+                                    &(user->qos_set), sp->partition_status,
+                                    NULL, "q", "Q");
+  if ((!show_all_partition) && (k == 0)) sp->visible = 0;
+
+  k = sp_check_permision_set_legend(sp_str(strs, sp->deny_qos),
+                                    &(user->qos_set), sp->partition_status,
+                                    "Q", "q", NULL);
+  if ((!show_all_partition) && (k == 0)) sp->visible = 0;
+
+  k = sp_check_permision_set_legend(sp_str(strs, sp->allow_groups),
+                                    &(user->group_set), sp->partition_status,
+                                    NULL, "g", "G");
+  if ((!show_all_partition) && (k == 0)) sp->visible = 0;
+  if (k == 0) listed = 0;
+
+#endif
+
+  if (strncmp(user->user_name, "root", SPART_INFO_STRING_SIZE) == 0) {
+    /* the slurm lists all partitions to root */
+    listed = 1;
+    if (sp->flags & PART_FLAG_NO_ROOT) {
+      sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "R", 2);
+      if (!show_all_partition) sp->visible = 0;
+    }
+  } else {
+    if (sp->flags & PART_FLAG_ROOT_ONLY) {
+      sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "R", 2);
+      if (!show_all_partition) sp->visible = 0;
+    }
+  }
+
+  if (!(sp->state_up == PARTITION_UP)) {
+    if (sp->state_up == PARTITION_INACTIVE)
+      sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "C", 2);
+    if (sp->state_up == PARTITION_DRAIN)
+      sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "S", 2);
+    if (sp->state_up == PARTITION_DOWN)
+      sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "D", 2);
+  }
+
+  if (sp->flags & PART_FLAG_REQ_RESV)
+    sp_strn2cat(sp->partition_status, SPART_STATUS_SIZE, "r", 2);
+
+  /* if (sp->flags & PART_FLAG_EXCLUSIVE_USER)
+    strncat(sp->partition_status, "x", SPART_STATUS_SIZE);*/
+
+  return listed;
+}
+
 #endif /* SPART_SPART_DATA_H_incl */
@@ -0,0 +1,191 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_FETCH_H_incl
+#define SPART_SPART_FETCH_H_incl
+
+#include <pthread.h>
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "spart.h"
+#include "spart_user.h"
+
+/* The error messages of the slurm requests, same order with the
+ * SPART_FETCH_ numbers */
+const char *sp_fetch_error_info[] = {
+    "slurm_load_ctl_conf error", "slurm_load_jobs error",
+    "slurm_load_node error", "slurm_load_partitions error",
+    "Can not connect to the slurm database", "Can not read User group list"};
+
+/* The names of the slurm requests, for the timing info */
+const char *sp_fetch_name[] = {"ctl_conf",   "jobs",         "nodes",
+                               "partitions", "associations", "groups"};
+
+/* Returns the monotonic time as seconds */
+double sp_time_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Sets the error number and the elapsed time of a request. Returns 1, if
+ * new data is loaded. If the data is not changed since the last load,
+ * it is not an error, the old data is used. */
+int sp_fetch_done(sp_fetch_request_t *req, int rc, double started) {
+  req->error = (rc == 0) ? 0 : slurm_get_errno();
+  /* some slurm versions return an error without setting errno */
+  if ((rc != 0) && (req->error == 0)) req->error = SLURM_ERROR;
+  if (req->error == SLURM_NO_CHANGE_IN_DATA) req->error = 0;
+  req->changed = (rc == 0);
+  req->seconds = sp_time_now() - started;
+  return req->changed;
+}
+
+/* The fetchers send the update time of the loaded data, so the slurmctld
+ * does not send the same data again. At the first call, they are NULL. */
+void *sp_fetch_conf(void *arg) {
+  sp_fetch_t *spf = arg;
+  double started = sp_time_now();
+#if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
+  slurm_conf_t *old = spf->conf_info_msg_ptr, *new_ptr = NULL;
+#else
+  slurm_ctl_conf_t *old = spf->conf_info_msg_ptr, *new_ptr = NULL;
+#endif
+  int rc = slurm_load_ctl_conf((old != NULL) ? old->last_update : (time_t)NULL,
+                               &new_ptr);
+  if (sp_fetch_done(&(spf->request[SPART_FETCH_CONF]), rc, started)) {
+    if (old != NULL) slurm_free_ctl_conf(old);
+    spf->conf_info_msg_ptr = new_ptr;
+  }
+  return NULL;
+}
+
+void *sp_fetch_jobs(void *arg) {
+  sp_fetch_t *spf = arg;
+  double started = sp_time_now();
+  job_info_msg_t *old = spf->job_buffer_ptr, *new_ptr = NULL;
+  int rc = slurm_load_jobs((old != NULL) ? old->last_update : (time_t)NULL,
+                           &new_ptr, SHOW_ALL);
+  if (sp_fetch_done(&(spf->request[SPART_FETCH_JOBS]), rc, started)) {
+    if (old != NULL) slurm_free_job_info_msg(old);
+    spf->job_buffer_ptr = new_ptr;
+  }
+  return NULL;
+}
+
+void *sp_fetch_nodes(void *arg) {
+  sp_fetch_t *spf = arg;
+  double started = sp_time_now();
+  node_info_msg_t *old = spf->node_buffer_ptr, *new_ptr = NULL;
+  int rc = slurm_load_node((old != NULL) ? old->last_update : (time_t)NULL,
+                           &new_ptr, SHOW_ALL);
+  if (sp_fetch_done(&(spf->request[SPART_FETCH_NODES]), rc, started)) {
+    if (old != NULL) slurm_free_node_info_msg(old);
+    spf->node_buffer_ptr = new_ptr;
+  }
+  return NULL;
+}
+
+void *sp_fetch_partitions(void *arg) {
+  sp_fetch_t *spf = arg;
+  double started = sp_time_now();
+  partition_info_msg_t *old = spf->part_buffer_ptr, *new_ptr = NULL;
+  int rc = slurm_load_partitions(
+      (old != NULL) ? old->last_update : (time_t)NULL, &new_ptr,
+      spf->show_partition);
+  if (sp_fetch_done(&(spf->request[SPART_FETCH_PARTITIONS]), rc, started)) {
+    if (old != NULL) slurm_free_partition_info_msg(old);
+    spf->part_buffer_ptr = new_ptr;
+  }
+  return NULL;
+}
+
+void *sp_fetch_assoc(void *arg) {
+  sp_fetch_t *spf = arg;
+  double started = sp_time_now();
+  sp_fetch_request_t *req = &(spf->request[SPART_FETCH_ASSOC]);
+  req->error = sp_user_assoc_load(spf->user, spf->assoc_refresh);
+  req->changed = (req->error == 0);
+  req->seconds = sp_time_now() - started;
+  return NULL;
+}
+
+void *sp_fetch_groups(void *arg) {
+  sp_fetch_t *spf = arg;
+  double started = sp_time_now();
+  sp_fetch_request_t *req = &(spf->request[SPART_FETCH_GROUPS]);
+  req->error = sp_user_groups_get(spf->user);
+  req->changed = (req->error == 0);
+  req->seconds = sp_time_now() - started;
+  return NULL;
+}
+
+/* Sends the wanted slurm requests at the same time, and waits for all of
+ * them. If a thread can not be created, that request runs at this thread. */
+void sp_fetch_all(sp_fetch_t *spf) {
+  void *(*fetcher[SPART_FETCH_COUNT])(void *) = {
+      sp_fetch_conf, sp_fetch_jobs, sp_fetch_nodes, sp_fetch_partitions,
+      sp_fetch_assoc, sp_fetch_groups};
+  pthread_t threads[SPART_FETCH_COUNT];
+  int started[SPART_FETCH_COUNT];
+  int k;
+#ifdef SPART_SHOW_PROFILE
+  double begin = sp_time_now();
+#endif
+
+  for (k = 0; k < SPART_FETCH_COUNT; k++) {
+    started[k] = 0;
+    if (!(spf->wanted & (1 << k))) continue;
+    started[k] = (pthread_create(&threads[k], NULL, fetcher[k], spf) == 0);
+    if (!started[k]) fetcher[k](spf);
+  }
+  for (k = 0; k < SPART_FETCH_COUNT; k++)
+    if (started[k]) pthread_join(threads[k], NULL);
+
+#ifdef SPART_SHOW_PROFILE
+  for (k = 0; k < SPART_FETCH_COUNT; k++)
+    if (spf->wanted & (1 << k))
+      fprintf(stderr, "spart: %-12s %8.3f s\n", sp_fetch_name[k],
+              spf->request[k].seconds);
+  fprintf(stderr, "spart: %-12s %8.3f s\n", "fetch total",
+          sp_time_now() - begin);
+#endif
+}
+
+/* Returns the first failed request of the last call, or -1 */
+int sp_fetch_failed(sp_fetch_t *spf) {
+  int k;
+  for (k = 0; k < SPART_FETCH_COUNT; k++)
+    if ((spf->wanted & (1 << k)) && (spf->request[k].error)) return k;
+  return -1;
+}
+
+/* Returns the SPART_FETCH_ bits of the requests, which loaded new data at
+ * the last call */
+uint16_t sp_fetch_changes(sp_fetch_t *spf) {
+  uint16_t changes = 0;
+  int k;
+  for (k = 0; k < SPART_FETCH_COUNT; k++)
+    if ((spf->wanted & (1 << k)) && (spf->request[k].changed))
+      changes |= (1 << k);
+  return changes;
+}
+
+/* Prints the error of the first failed request, and exits */
+void sp_fetch_check(sp_fetch_t *spf) {
+  int k = sp_fetch_failed(spf);
+  if (k >= 0) {
+    fprintf(stderr, "%s: %s\n", sp_fetch_error_info[k],
+            slurm_strerror(spf->request[k].error));
+    exit(1);
+  }
+}
+
+#endif /* SPART_SPART_FETCH_H_incl */
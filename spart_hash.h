@@ -0,0 +1,124 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_HASH_H_incl
+#define SPART_SPART_HASH_H_incl
+
+#include <slurm/slurm_errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPART_HASH_EMPTY UINT32_MAX
+
+/* One slot of the hash table. The key is not copied, it should live
+ * as long as the table. */
+typedef struct sp_hash_entry {
+  const char *key;
+  uint32_t len;
+  uint32_t value;
+} sp_hash_entry_t;
+
+/* A string to uint32_t hash table with open addressing */
+typedef struct sp_hash {
+  uint32_t size; /* always a power of two */
+  uint32_t count;
+  sp_hash_entry_t *entries;
+} sp_hash_t;
+
+/* FNV-1a hash of the first len chars of key */
+uint32_t sp_hash_str(const char *key, uint32_t len) {
+  uint32_t h = 2166136261u;
+  uint32_t i;
+  for (i = 0; i < len; i++) {
+    h ^= (unsigned char)key[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* Allocates an empty table for at least expected keys */
+void sp_hash_init(sp_hash_t *h, uint32_t expected) {
+  h->size = 16;
+  while (h->size < expected * 2) h->size <<= 1;
+  h->count = 0;
+  h->entries = calloc(h->size, sizeof(sp_hash_entry_t));
+  if (h->entries == NULL) {
+    slurm_perror("Can not allocate hash table");
+    exit(1);
+  }
+}
+
+void sp_hash_free(sp_hash_t *h) {
+  free(h->entries);
+  h->entries = NULL;
+  h->size = 0;
+  h->count = 0;
+}
+
+/* Returns the slot of the key, or the empty slot where it should be */
+sp_hash_entry_t *sp_hash_lookup(const sp_hash_t *h, const char *key,
+                                uint32_t len) {
+  uint32_t mask = h->size - 1;
+  uint32_t i = sp_hash_str(key, len) & mask;
+  sp_hash_entry_t *e;
+
+  for (;;) {
+    e = &(h->entries[i]);
+    if (e->key == NULL) return e;
+    if ((e->len == len) && (memcmp(e->key, key, len) == 0)) return e;
+    i = (i + 1) & mask;
+  }
+}
+
+/* Returns the value of the key, or SPART_HASH_EMPTY if it is not found */
+uint32_t sp_hash_get(const sp_hash_t *h, const char *key, uint32_t len) {
+  sp_hash_entry_t *e;
+  if (h->count == 0) return SPART_HASH_EMPTY;
+  e = sp_hash_lookup(h, key, len);
+  if (e->key == NULL) return SPART_HASH_EMPTY;
+  return e->value;
+}
+
+/* Doubles the table size, and reinserts all keys */
+void sp_hash_grow(sp_hash_t *h) {
+  sp_hash_t nh;
+  uint32_t i;
+
+  nh.size = h->size * 2;
+  nh.count = h->count;
+  nh.entries = calloc(nh.size, sizeof(sp_hash_entry_t));
+  if (nh.entries == NULL) {
+    slurm_perror("Can not allocate hash table");
+    exit(1);
+  }
+  for (i = 0; i < h->size; i++)
+    if (h->entries[i].key != NULL)
+      *sp_hash_lookup(&nh, h->entries[i].key, h->entries[i].len) =
+          h->entries[i];
+  free(h->entries);
+  *h = nh;
+}
+
+/* Returns a pointer to the value of the key. If the key is not found, it
+ * is added with the SPART_HASH_EMPTY value. The pointer is valid until the
+ * next insertion. */
+uint32_t *sp_hash_slot(sp_hash_t *h, const char *key, uint32_t len) {
+  sp_hash_entry_t *e;
+
+  if ((h->count + 1) * 2 > h->size) sp_hash_grow(h);
+  e = sp_hash_lookup(h, key, len);
+  if (e->key == NULL) {
+    e->key = key;
+    e->len = len;
+    e->value = SPART_HASH_EMPTY;
+    h->count++;
+  }
+  return &(e->value);
+}
+
+#endif /* SPART_SPART_HASH_H_incl */
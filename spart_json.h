@@ -0,0 +1,127 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_JSON_H_incl
+#define SPART_SPART_JSON_H_incl
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "spart_string.h"
+
+#define SPART_JSON_BUFFER_SIZE 4096
+
+/* Writes one JSON object per line. The objects are encoded into a small
+ * fixed buffer, which is written at the end of each line, or when it is
+ * full. So the encoder does not allocate memory, and the reader gets each
+ * line, when it is ended. */
+typedef struct sp_json {
+  int fd;
+  /* the next key is the first key of the object */
+  int first;
+  size_t len;
+  char buf[SPART_JSON_BUFFER_SIZE];
+} sp_json_t;
+
+void sp_json_init(sp_json_t *js, int fd) {
+  js->fd = fd;
+  js->first = 1;
+  js->len = 0;
+}
+
+/* Writes the buffered lines */
+void sp_json_flush(sp_json_t *js) {
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < js->len) {
+    n = write(js->fd, js->buf + done, js->len - done);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    done += n;
+  }
+  js->len = 0;
+}
+
+void sp_json_putn(sp_json_t *js, const char *str, size_t n) {
+  size_t part;
+
+  while (n > 0) {
+    if (js->len == SPART_JSON_BUFFER_SIZE) sp_json_flush(js);
+    part = SPART_JSON_BUFFER_SIZE - js->len;
+    if (part > n) part = n;
+    memcpy(js->buf + js->len, str, part);
+    js->len += part;
+    str += part;
+    n -= part;
+  }
+}
+
+/* Starts an object */
+void sp_json_begin(sp_json_t *js) {
+  sp_json_putn(js, "{", 1);
+  js->first = 1;
+}
+
+/* Ends an object. An object at the top level ends the line, and the line
+ * is written. */
+void sp_json_end(sp_json_t *js, int line) {
+  js->first = 0;
+  if (line) {
+    sp_json_putn(js, "}\n", 2);
+    sp_json_flush(js);
+  } else {
+    sp_json_putn(js, "}", 1);
+  }
+}
+
+/* Adds a string value, with the JSON escapes */
+void sp_json_str(sp_json_t *js, const char *str) {
+  const char *hex = "0123456789abcdef";
+  const char *run = str;
+  char esc[6] = {'\\', 'u', '0', '0', 0, 0};
+  unsigned char ch;
+
+  sp_json_putn(js, "\"", 1);
+  for (; *str != '\0'; str++) {
+    ch = (unsigned char)*str;
+    if ((ch >= 0x20) && (ch != '"') && (ch != '\\')) continue;
+    sp_json_putn(js, run, str - run);
+    run = str + 1;
+    if ((ch == '"') || (ch == '\\')) {
+      esc[1] = ch;
+      sp_json_putn(js, esc, 2);
+      esc[1] = 'u';
+    } else {
+      esc[4] = hex[ch >> 4];
+      esc[5] = hex[ch & 15];
+      sp_json_putn(js, esc, 6);
+    }
+  }
+  sp_json_putn(js, run, str - run);
+  sp_json_putn(js, "\"", 1);
+}
+
+/* Adds the key of the next value */
+void sp_json_key(sp_json_t *js, const char *key) {
+  if (!(js->first)) sp_json_putn(js, ",", 1);
+  js->first = 0;
+  sp_json_str(js, key);
+  sp_json_putn(js, ":", 1);
+}
+
+void sp_json_int(sp_json_t *js, int64_t num) {
+  char str[24];
+  sp_json_putn(js, str, sp_int_str(str, num));
+}
+
+void sp_json_null(sp_json_t *js) { sp_json_putn(js, "null", 4); }
+
+#endif /* SPART_SPART_JSON_H_incl */
@@ -0,0 +1,265 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_LIB_H_incl
+#define SPART_SPART_LIB_H_incl
+
+/* The partition queries without the output. A program, such as a
+ * monitoring agent or a web portal, can load the slurm data, compute the
+ * partitions, and check them for a user with these functions, and it can
+ * format the sp_part_info_t records itself:
+ *
+ *   sp_lib_init(&lib, &user, SHOW_ALL, &plan);
+ *   for (;;) {
+ *     if (sp_lib_fetch(&lib)) {
+ *       sp_lib_compute(&lib);
+ *       sp_lib_identity(&lib, 0);
+ *       sp_lib_evaluate(&lib, 0, 0);
+ *       ... lib.parts[0 .. lib.part_count - 1] ...
+ *     }
+ *     sleep(30);
+ *   }
+ *   sp_lib_free(&lib);
+ *
+ * The slurm buffers are kept between the calls, so the slurmctld sends only
+ * the changed data. The strings of the partitions are read with
+ * sp_str(lib.strs, offset). */
+
+#include <slurm/slurm.h>
+#include <stdint.h>
+#include <string.h>
+#include "spart.h"
+#include "spart_arena.h"
+#include "spart_data.h"
+#include "spart_fetch.h"
+#include "spart_hash.h"
+#include "spart_pool.h"
+#include "spart_record.h"
+#include "spart_string.h"
+#include "spart_user.h"
+
+/* It is increased, if the sp_lib_ functions or the sp_lib_t fields, which
+ * are read by the callers, are changed incompatibly */
+#define SPART_LIB_VERSION 1
+
+typedef struct sp_lib {
+  /* the slurm buffers, which are kept between the refreshes */
+  sp_fetch_t fetch;
+  /* the computations, and the slurm requests which they need */
+  sp_plan_t plan;
+
+  /* the partitions of the last computation, and their strings */
+  sp_part_info_t *parts;
+  uint32_t part_count;
+  const sp_strpool_t *strs;
+  uint16_t private_data;
+  char cluster_name[SPART_MAX_COLUMN_SIZE];
+  /* 0 for the partitions, which are hidden by sp_lib_evaluate, because the
+   * slurm would not list them to the user */
+  uint8_t *listed;
+
+  /* if not NULL, only the partitions of this name set are computed */
+  const sp_hash_t *given;
+  /* if not NULL, the job counts of all users are added to this list */
+  sp_user_jobs_list_t *user_jobs;
+  /* if not NULL, the slurm data is read from this record, not from the
+   * slurmctld */
+  sp_record_t *record;
+
+  /* the request which failed at the last fetch, or -1 */
+  int failed;
+  /* the SPART_FETCH_ bits of the data, which is changed after the last
+   * computation */
+  uint16_t dirty;
+  /* the SPART_FETCH_ bits of the loaded user info */
+  uint16_t identity_loaded;
+  uint32_t computed;
+
+  sp_arena_t arena;
+  /* the node values, which are kept while the nodes are not changed */
+  sp_arena_t node_arena;
+  sp_node_info_t *nodes;
+  uint8_t *selected;
+  sp_strpool_t strings;
+} sp_lib_t;
+
+/* Prepares the queries of a user. The plan can be made with sp_plan_make
+ * of spart_output.h from the visible columns, or it can compute all
+ * values. */
+void sp_lib_init(sp_lib_t *lib, sp_user_info_t *user, uint16_t show_partition,
+                 const sp_plan_t *plan) {
+  memset(lib, 0, sizeof(sp_lib_t));
+  lib->fetch.show_partition = show_partition;
+  lib->fetch.user = user;
+  lib->plan = *plan;
+  lib->failed = -1;
+  lib->strs = &(lib->strings);
+}
+
+/* Loads the slurm data, which is changed after the last fetch. Returns 1,
+ * if the partitions should be computed again. If a request fails, it is
+ * set to lib->failed, and 0 is returned; the data of the last computation
+ * is still valid. */
+int sp_lib_fetch(sp_lib_t *lib) {
+  if (lib->record != NULL) return (lib->computed == 0);
+  lib->fetch.wanted = lib->plan.wanted;
+  sp_fetch_all(&(lib->fetch));
+  lib->dirty |= sp_fetch_changes(&(lib->fetch));
+  lib->failed = sp_fetch_failed(&(lib->fetch));
+  if (lib->failed >= 0) return 0;
+  return (lib->computed == 0) || (lib->dirty != 0);
+}
+
+/* Computes the partition values from the loaded slurm data. The node
+ * values are computed once, even if the node is in many partitions, and
+ * they are kept while the nodes and the partitions are not changed. */
+void sp_lib_compute(sp_lib_t *lib) {
+  partition_info_msg_t *part_buffer_ptr = lib->fetch.part_buffer_ptr;
+  node_info_msg_t *node_buffer_ptr = lib->fetch.node_buffer_ptr;
+  sp_part_index_t part_index;
+
+  sp_arena_free(&(lib->arena));
+  sp_strpool_free(&(lib->strings));
+  lib->listed = NULL;
+  lib->private_data = lib->fetch.conf_info_msg_ptr->private_data;
+  lib->cluster_name[0] = 0;
+#ifdef __slurmdb_cluster_rec_t_defined
+  sp_strn2cpy(lib->cluster_name, SPART_MAX_COLUMN_SIZE,
+              lib->fetch.conf_info_msg_ptr->cluster_name,
+              SPART_MAX_COLUMN_SIZE);
+#endif
+
+  if ((lib->computed == 0) ||
+      (lib->dirty &
+       ((1 << SPART_FETCH_NODES) | (1 << SPART_FETCH_PARTITIONS)))) {
+    sp_arena_free(&(lib->node_arena));
+    lib->selected = NULL;
+    lib->nodes = NULL;
+    if (lib->given != NULL)
+      lib->selected =
+          sp_parts_select(&(lib->node_arena), part_buffer_ptr, lib->given);
+    if (node_buffer_ptr != NULL)
+      lib->nodes = sp_nodes_read(
+          &(lib->node_arena), node_buffer_ptr, part_buffer_ptr, lib->selected,
+          (lib->record != NULL) ? lib->record->alloc_cpus : NULL);
+  }
+
+  sp_strpool_init(&(lib->strings));
+  lib->strs = &(lib->strings);
+  lib->part_count = part_buffer_ptr->record_count;
+  lib->parts = sp_parts_read(&(lib->arena), part_buffer_ptr, node_buffer_ptr,
+                             lib->nodes,
+#ifdef __slurmdb_cluster_rec_t_defined
+                             lib->cluster_name,
+#else
+                             NULL,
+#endif
+                             lib->plan.compute, lib->selected,
+                             &(lib->strings));
+
+  /* Finds resource/other waiting core count for each partition. The job
+   * counts of the other users are not collected, if the slurm hides them. */
+  if (lib->fetch.job_buffer_ptr != NULL) {
+    sp_part_index_build(&part_index, part_buffer_ptr, lib->selected);
+    if (lib->user_jobs != NULL) lib->user_jobs->count = 0;
+    sp_jobs_count(lib->parts, &part_index, lib->fetch.job_buffer_ptr,
+                  (lib->plan.compute & SPART_PLAN_MY_JOBS)
+                      ? lib->fetch.user->user_id
+                      : -1,
+                  (lib->private_data == 0) ? lib->user_jobs : NULL);
+    sp_part_index_free(&part_index);
+  }
+  lib->dirty = 0;
+  lib->computed++;
+}
+
+#ifdef SPART_USE_SNAPSHOT
+/* Uses the partitions of a snapshot, instead of computing them. The
+ * snapshot should live as long as the partitions are used. */
+void sp_lib_use_snapshot(sp_lib_t *lib, sp_snapshot_t *snap) {
+  lib->private_data = snap->private_data;
+  sp_strn2cpy(lib->cluster_name, SPART_MAX_COLUMN_SIZE, snap->cluster_name,
+              SPART_MAX_COLUMN_SIZE);
+  lib->part_count = snap->partition_count;
+  lib->parts = snap->spData;
+  lib->strs = &(snap->strings);
+  lib->listed = NULL;
+  sp_user_jobs_find(lib->parts, lib->part_count, snap->user_jobs,
+                    snap->user_jobs_count, lib->fetch.user->user_id);
+}
+#endif
+
+/* Uses the slurm data and the user info of a record, instead of loading
+ * them. The record should live as long as the partitions are used. */
+void sp_lib_use_record(sp_lib_t *lib, sp_record_t *rec) {
+  lib->record = rec;
+  lib->fetch.conf_info_msg_ptr = &(rec->conf);
+  lib->fetch.node_buffer_ptr = &(rec->nodes);
+  lib->fetch.part_buffer_ptr = &(rec->parts);
+  lib->fetch.job_buffer_ptr = &(rec->jobs);
+  lib->fetch.show_partition = rec->show_partition;
+  lib->identity_loaded = (1 << SPART_FETCH_ASSOC) | (1 << SPART_FETCH_GROUPS);
+}
+
+/* Loads the accounts, QOSs and groups of the user, which are needed by the
+ * access lists of the partitions, or all of them. Each of them is loaded
+ * once. Returns the failed request, or -1. */
+int sp_lib_identity(sp_lib_t *lib, int all) {
+  uint16_t wanted;
+
+  if (all)
+    wanted = (1 << SPART_FETCH_ASSOC) | (1 << SPART_FETCH_GROUPS);
+  else
+    wanted = sp_parts_identity_needs(lib->parts, lib->part_count);
+  lib->fetch.wanted = wanted & ~(lib->identity_loaded);
+  if (!(lib->fetch.wanted)) return -1;
+  sp_fetch_all(&(lib->fetch));
+  lib->failed = sp_fetch_failed(&(lib->fetch));
+  if (lib->failed < 0) lib->identity_loaded |= lib->fetch.wanted;
+  return lib->failed;
+}
+
+/* Sets the status and the visibility of the partitions for the user. If
+ * hide_unlisted is set, the partitions, which the slurm would not list to
+ * the user without SHOW_ALL, are hidden, and their listed flag is 0. */
+void sp_lib_evaluate(sp_lib_t *lib, int show_all_partition,
+                     int hide_unlisted) {
+  sp_user_info_t *user = lib->fetch.user;
+  uint32_t i;
+
+  /* the sets keep the results of the access lists of the last strings */
+  sp_user_sets_free(user);
+  sp_user_sets_build(user);
+  lib->listed = sp_arena_alloc(&(lib->arena), lib->part_count + 1);
+  for (i = 0; i < lib->part_count; i++) {
+    lib->listed[i] =
+        sp_part_set_status(&(lib->parts[i]), lib->strs, user,
+                           show_all_partition) ||
+        (!hide_unlisted);
+    if (!(lib->listed[i])) lib->parts[i].visible = 0;
+  }
+}
+
+/* Frees the partitions and the slurm buffers. The buffers of a record are
+ * freed with the record. */
+void sp_lib_free(sp_lib_t *lib) {
+  sp_arena_free(&(lib->arena));
+  sp_arena_free(&(lib->node_arena));
+  sp_strpool_free(&(lib->strings));
+  if (lib->record != NULL) memset(&(lib->fetch), 0, sizeof(sp_fetch_t));
+  if (lib->fetch.job_buffer_ptr != NULL)
+    slurm_free_job_info_msg(lib->fetch.job_buffer_ptr);
+  if (lib->fetch.node_buffer_ptr != NULL)
+    slurm_free_node_info_msg(lib->fetch.node_buffer_ptr);
+  if (lib->fetch.part_buffer_ptr != NULL)
+    slurm_free_partition_info_msg(lib->fetch.part_buffer_ptr);
+  if (lib->fetch.conf_info_msg_ptr != NULL)
+    slurm_free_ctl_conf(lib->fetch.conf_info_msg_ptr);
+  memset(lib, 0, sizeof(sp_lib_t));
+}
+
+#endif /* SPART_SPART_LIB_H_incl */
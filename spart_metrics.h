@@ -0,0 +1,123 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_METRICS_H_incl
+#define SPART_SPART_METRICS_H_incl
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "spart.h"
+#include "spart_output.h"
+#include "spart_pool.h"
+#include "spart_string.h"
+
+/* A gauge of the partition values */
+typedef struct sp_metric {
+  const char *name;
+  const char *unit;
+  const char *help;
+  size_t value;
+  uint16_t value_size;
+  /* the value is known only if the partition has nodes */
+  uint16_t node_limit;
+  /* the value is multiplied with the scale, such as MB to bytes */
+  uint32_t scale;
+} sp_metric_t;
+
+/* The metrics, which are written with the --metrics parameter */
+const sp_metric_t sp_metrics[] = {
+    {"spart_free_cores", NULL, "The unallocated cores of the usable nodes.",
+     SPART_VALUE(free_cpu), 0, 1},
+    {"spart_total_cores", NULL, "The cores of the partition.",
+     SPART_VALUE(total_cpu), 0, 1},
+    {"spart_free_nodes", NULL, "The usable nodes without an allocated core.",
+     SPART_VALUE(free_node), 0, 1},
+    {"spart_total_nodes", NULL, "The nodes of the partition.",
+     SPART_VALUE(total_node), 0, 1},
+    {"spart_resource_pending_cores", NULL,
+     "The cores of the jobs, which are pending for the resources.",
+     SPART_VALUE(waiting_resource), 0, 1},
+    {"spart_other_pending_cores", NULL,
+     "The cores of the jobs, which are pending for the other reasons.",
+     SPART_VALUE(waiting_other), 0, 1},
+    {"spart_node_min_cores", NULL, "The cores of the node with fewest cores.",
+     SPART_VALUE(min_core), 1, 1},
+    {"spart_node_max_cores", NULL, "The cores of the node with most cores.",
+     SPART_VALUE(max_core), 1, 1},
+    {"spart_node_min_memory_bytes", "bytes",
+     "The memory of the node with least memory.", SPART_VALUE(min_mem_mb), 1,
+     1048576},
+    {"spart_node_max_memory_bytes", "bytes",
+     "The memory of the node with most memory.", SPART_VALUE(max_mem_mb), 1,
+     1048576}};
+
+#define SPART_METRIC_COUNT (sizeof(sp_metrics) / sizeof(sp_metrics[0]))
+
+/* Adds a label value, with the OpenMetrics escapes */
+void sp_metrics_label(sp_strbuf_t *out, const char *name, const char *str) {
+  const char *run = str;
+
+  sp_strbuf_cat(out, name);
+  sp_strbuf_catn(out, "=\"", 2);
+  for (; *str != '\0'; str++) {
+    if ((*str != '"') && (*str != '\\') && (*str != '\n')) continue;
+    sp_strbuf_catn(out, run, str - run);
+    run = str + 1;
+    if (*str == '\n') {
+      sp_strbuf_catn(out, "\\n", 2);
+    } else {
+      sp_strbuf_catn(out, "\\", 1);
+      sp_strbuf_catn(out, str, 1);
+    }
+  }
+  sp_strbuf_catn(out, run, str - run);
+  sp_strbuf_catn(out, "\"", 1);
+}
+
+/* Adds the gauges of the visible partitions. The samples of a metric are
+ * written together, as the OpenMetrics wants. */
+void sp_metrics_print(sp_strbuf_t *out, const sp_part_info_t *spData,
+                      uint32_t partition_count, const sp_strpool_t *strs) {
+  const sp_metric_t *m;
+  const char *cluster;
+  size_t k;
+  uint32_t i;
+
+  for (k = 0; k < SPART_METRIC_COUNT; k++) {
+    m = &sp_metrics[k];
+    sp_strbuf_printf(out, "# TYPE %s gauge\n", m->name);
+    if (m->unit != NULL)
+      sp_strbuf_printf(out, "# UNIT %s %s\n", m->name, m->unit);
+    sp_strbuf_printf(out, "# HELP %s %s\n", m->name, m->help);
+    for (i = 0; i < partition_count; i++) {
+      if (!(spData[i].visible)) continue;
+      /* the partition has no node */
+      if ((m->node_limit) && (spData[i].max_core == 0)) continue;
+      sp_strbuf_cat(out, m->name);
+      sp_strbuf_catn(out, "{", 1);
+      cluster = sp_str(strs, spData[i].cluster_name);
+      if (cluster[0] != '\0') {
+        sp_metrics_label(out, "cluster", cluster);
+        sp_strbuf_catn(out, ",", 1);
+      }
+      sp_metrics_label(out, "partition",
+                       sp_str(strs, spData[i].partition_name));
+      sp_strbuf_catn(out, "} ", 2);
+      sp_strbuf_int(out,
+                    (int64_t)sp_column_num(&(spData[i]), m->value,
+                                           m->value_size) *
+                        m->scale,
+                    0, ' ');
+      sp_strbuf_catn(out, "\n", 1);
+    }
+  }
+  sp_strbuf_cat(out, "# EOF\n");
+}
+
+#endif /* SPART_SPART_METRICS_H_incl */
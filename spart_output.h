@@ -14,282 +14,36 @@
 #include <slurm/slurm.h>
 #include <slurm/slurm_errno.h>
 #include <slurm/slurmdb.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "spart.h"
 #include "spart_string.h"
 #include "spart_data.h"
+#include "spart_json.h"
 #include "spart_output.h"
 
-/* Initialize all column headers */
-void sp_headers_set_defaults(sp_headers_t *sph) {
-  sph->hspace.visible = 0;
-  sph->hspace.column_width = 17;
-  sp_strn2cpy(sph->hspace.line1, sph->hspace.column_width, "           ",
-              sph->hspace.column_width+1);
-  sp_strn2cpy(sph->hspace.line2, sph->hspace.column_width, "           ",
-              sph->hspace.column_width+1);
-#ifdef __slurmdb_cluster_rec_t_defined
-  sph->cluster_name.visible = 0;
-  sph->cluster_name.column_width = 8;
-  sp_strn2cpy(sph->cluster_name.line1, sph->cluster_name.column_width,
-              " CLUSTER", sph->cluster_name.column_width+1);
-  sp_strn2cpy(sph->cluster_name.line2, sph->cluster_name.column_width,
-              "    NAME", sph->cluster_name.column_width+1);
-#endif
-  sph->partition_name.visible = 1;
-  sph->partition_name.column_width = 10;
-  sp_strn2cpy(sph->partition_name.line1, sph->partition_name.column_width,
-              "     QUEUE", sph->partition_name.column_width+1);
-  sp_strn2cpy(sph->partition_name.line2, sph->partition_name.column_width,
-              " PARTITION", sph->partition_name.column_width+1);
-  sph->partition_status.visible = 1;
-  sph->partition_status.column_width = 3;
-  sp_strn2cpy(sph->partition_status.line1, sph->partition_status.column_width,
-              "STA", sph->partition_status.column_width+1);
-  sp_strn2cpy(sph->partition_status.line2, sph->partition_status.column_width,
-              "TUS", sph->partition_status.column_width+1);
-  sph->free_cpu.visible = 1;
-  sph->free_cpu.column_width = 6;
-  sp_strn2cpy(sph->free_cpu.line1, sph->free_cpu.column_width, "  FREE",
-              sph->free_cpu.column_width+1);
-  sp_strn2cpy(sph->free_cpu.line2, sph->free_cpu.column_width, " CORES",
-              sph->free_cpu.column_width+1);
-  sph->total_cpu.visible = 1;
-  sph->total_cpu.column_width = 6;
-  sp_strn2cpy(sph->total_cpu.line1, sph->total_cpu.column_width, " TOTAL",
-              sph->total_cpu.column_width+1);
-  sp_strn2cpy(sph->total_cpu.line2, sph->total_cpu.column_width, " CORES",
-              sph->total_cpu.column_width+1);
-  sph->free_node.visible = 1;
-  sph->free_node.column_width = 6;
-  sp_strn2cpy(sph->free_node.line1, sph->free_node.column_width, "  FREE",
-              sph->free_node.column_width+1);
-  sp_strn2cpy(sph->free_node.line2, sph->free_node.column_width, " NODES",
-              sph->free_node.column_width+1);
-  sph->total_node.visible = 1;
-  sph->total_node.column_width = 6;
-  sp_strn2cpy(sph->total_node.line1, sph->total_node.column_width, " TOTAL",
-              sph->total_node.column_width+1);
-  sp_strn2cpy(sph->total_node.line2, sph->total_node.column_width, " NODES",
-              sph->total_node.column_width+1);
-  sph->waiting_resource.visible = 1;
-  sph->waiting_resource.column_width = 6;
-  sp_strn2cpy(sph->waiting_resource.line1, sph->waiting_resource.column_width,
-              "RESORC", sph->waiting_resource.column_width+1);
-  sp_strn2cpy(sph->waiting_resource.line2, sph->waiting_resource.column_width,
-              "PENDNG", sph->waiting_resource.column_width+1);
-  sph->waiting_other.visible = 1;
-  sph->waiting_other.column_width = 6;
-  sp_strn2cpy(sph->waiting_other.line1, sph->waiting_other.column_width,
-              " OTHER", sph->waiting_other.column_width+1);
-  sp_strn2cpy(sph->waiting_other.line2, sph->waiting_other.column_width,
-              "PENDNG", sph->waiting_other.column_width+1);
-  sph->my_running.visible = 1;
-  sph->my_running.column_width = 4;
-  sp_strn2cpy(sph->my_running.line1, sph->my_running.column_width, "YOUR",
-              sph->my_running.column_width+1);
-  sp_strn2cpy(sph->my_running.line2, sph->my_running.column_width, " RUN",
-              sph->my_running.column_width+1);
-  sph->my_waiting_resource.visible = 1;
-  sph->my_waiting_resource.column_width = 4;
-  sp_strn2cpy(sph->my_waiting_resource.line1,
-              sph->my_waiting_resource.column_width, "PEND",
-              sph->my_waiting_resource.column_width+1);
-  sp_strn2cpy(sph->my_waiting_resource.line2,
-              sph->my_waiting_resource.column_width, " RES",
-              sph->my_waiting_resource.column_width+1);
-  sph->my_waiting_other.visible = 1;
-  sph->my_waiting_other.column_width = 4;
-  sp_strn2cpy(sph->my_waiting_other.line1, sph->my_waiting_other.column_width,
-              "PEND", sph->my_waiting_other.column_width+1);
-  sp_strn2cpy(sph->my_waiting_other.line2, sph->my_waiting_other.column_width,
-              "OTHR", sph->my_waiting_other.column_width+1);
-  sph->my_total.visible = 1;
-  sph->my_total.column_width = 4;
-  sp_strn2cpy(sph->my_total.line1, sph->my_total.column_width, "YOUR",
-              sph->my_total.column_width+1);
-  sp_strn2cpy(sph->my_total.line2, sph->my_total.column_width, "TOTL",
-              sph->my_total.column_width+1);
-  sph->min_nodes.visible = 1;
-  sph->min_nodes.column_width = 5;
-  sp_strn2cpy(sph->min_nodes.line1, sph->min_nodes.column_width, "  MIN",
-              sph->min_nodes.column_width+1);
-  sp_strn2cpy(sph->min_nodes.line2, sph->min_nodes.column_width, "NODES",
-              sph->min_nodes.column_width+1);
-  sph->max_nodes.visible = 1;
-  sph->max_nodes.column_width = 5;
-  sp_strn2cpy(sph->max_nodes.line1, sph->max_nodes.column_width, "  MAX",
-              sph->max_nodes.column_width+1);
-  sp_strn2cpy(sph->max_nodes.line2, sph->max_nodes.column_width, "NODES",
-              sph->max_nodes.column_width+1);
-  sph->max_cpus_per_node.visible = 0;
-  sph->max_cpus_per_node.column_width = 6;
-  sp_strn2cpy(sph->max_cpus_per_node.line1, sph->max_cpus_per_node.column_width,
-              "MAXCPU", sph->max_cpus_per_node.column_width+1);
-  sp_strn2cpy(sph->max_cpus_per_node.line2, sph->max_cpus_per_node.column_width,
-              " /NODE", sph->max_cpus_per_node.column_width+1);
-  sph->max_mem_per_cpu.visible = 0;
-  sph->max_mem_per_cpu.column_width = 6;
-  sp_strn2cpy(sph->max_mem_per_cpu.line1, sph->max_mem_per_cpu.column_width,
-              "MAXMEM", sph->max_mem_per_cpu.column_width+1);
-  sp_strn2cpy(sph->max_mem_per_cpu.line2, sph->max_mem_per_cpu.column_width,
-              "GB/CPU", sph->max_mem_per_cpu.column_width+1);
-  sph->def_mem_per_cpu.visible = 0;
-  sph->def_mem_per_cpu.column_width = 6;
-  sp_strn2cpy(sph->def_mem_per_cpu.line1, sph->def_mem_per_cpu.column_width,
-              "DEFMEM", sph->def_mem_per_cpu.column_width+1);
-  sp_strn2cpy(sph->def_mem_per_cpu.line2, sph->def_mem_per_cpu.column_width,
-              "GB/CPU", sph->def_mem_per_cpu.column_width+1);
-  sph->djt_time.visible = 0;
-  sph->djt_time.column_width = 10;
-  sp_strn2cpy(sph->djt_time.line1, sph->djt_time.column_width, "   DEFAULT",
-              sph->djt_time.column_width+1);
-  sp_strn2cpy(sph->djt_time.line2, sph->djt_time.column_width, "  JOB-TIME",
-              sph->djt_time.column_width+1);
-  sph->mjt_time.visible = 1;
-  sph->mjt_time.column_width = 10;
-  sp_strn2cpy(sph->mjt_time.line1, sph->mjt_time.column_width, "   MAXIMUM",
-              sph->mjt_time.column_width+1);
-  sp_strn2cpy(sph->mjt_time.line2, sph->mjt_time.column_width, "  JOB-TIME",
-              sph->mjt_time.column_width+1);
-  sph->min_core.visible = 1;
-  sph->min_core.column_width = 6;
-  sp_strn2cpy(sph->min_core.line1, sph->min_core.column_width, " CORES",
-              sph->min_core.column_width+1);
-  sp_strn2cpy(sph->min_core.line2, sph->min_core.column_width, " /NODE",
-              sph->min_core.column_width+1);
-  sph->min_mem_gb.visible = 1;
-  sph->min_mem_gb.column_width = 6;
-  sp_strn2cpy(sph->min_mem_gb.line1, sph->min_mem_gb.column_width, "  NODE",
-              sph->min_mem_gb.column_width+1);
-  sp_strn2cpy(sph->min_mem_gb.line2, sph->min_mem_gb.column_width, "MEM-GB",
-              sph->min_mem_gb.column_width+1);
-  sph->partition_qos.visible = 1;
-  sph->partition_qos.column_width = 6;
-  sp_strn2cpy(sph->partition_qos.line1, sph->partition_qos.column_width,
-              "   QOS", sph->partition_qos.column_width+1);
-  sp_strn2cpy(sph->partition_qos.line2, sph->partition_qos.column_width,
-              "  NAME", sph->partition_qos.column_width+1);
-  sph->gres.visible = 0;
-  sph->gres.column_width = 12;
-  sp_strn2cpy(sph->gres.line1, sph->gres.column_width, " GRES       ",
-              sph->gres.column_width+1);
-  sp_strn2cpy(sph->gres.line2, sph->gres.column_width, "(NODE-COUNT)",
-              sph->gres.column_width+1);
-  sph->features.visible = 0;
-  sph->features.column_width = 12;
-  sp_strn2cpy(sph->features.line1, sph->features.column_width, " FEATURES   ",
-              sph->features.column_width+1);
-  sp_strn2cpy(sph->features.line2, sph->features.column_width, "(NODE-COUNT)",
-              sph->features.column_width+1);
-}
-
-/* Sets all columns as visible */
-void sp_headers_set_parameter_L(sp_headers_t *sph) {
-#ifdef __slurmdb_cluster_rec_t_defined
-  sph->cluster_name.visible = 0;
-  sph->partition_name.visible = SHOW_LOCAL;
-#else
-  sph->partition_name.visible = 1;
-#endif
-  sph->partition_status.visible = 1;
-  sph->free_cpu.visible = 1;
-  sph->total_cpu.visible = 1;
-  sph->free_node.visible = 1;
-  sph->total_node.visible = 1;
-  sph->waiting_resource.visible = 1;
-  sph->waiting_other.visible = 1;
-  sph->my_running.visible = 1;
-  sph->my_waiting_resource.visible = 1;
-  sph->my_waiting_other.visible = 1;
-  sph->my_total.visible = 1;
-  sph->min_nodes.visible = 1;
-  sph->max_nodes.visible = 1;
-  sph->max_cpus_per_node.visible = 1;
-  sph->max_mem_per_cpu.visible = 1;
-  sph->def_mem_per_cpu.visible = 1;
-  sph->djt_time.visible = 1;
-  sph->mjt_time.visible = 1;
-  sph->min_core.visible = 1;
-  sph->min_mem_gb.visible = 1;
-  sph->partition_qos.visible = 1;
-  sph->gres.visible = 1;
-  sph->features.visible = 0;
-  sph->min_core.column_width = 8;
-  sph->min_mem_gb.column_width = 10;
-}
-
-/* If column visible, it prints header to the line1 and line2 strings */
-void sp_column_header_print(char *line1, char *line2,
+/* If column visible, it adds header to the line1 and line2 strings */
+void sp_column_header_print(sp_strbuf_t *line1, sp_strbuf_t *line2,
                             sp_column_header_t *spcol) {
-  char cresult[SPART_MAX_COLUMN_SIZE];
   if (spcol->visible) {
-    snprintf(cresult, SPART_MAX_COLUMN_SIZE, "%*s", spcol->column_width,
-             spcol->line1);
-    sp_strn2cat(line1, SPART_INFO_STRING_SIZE, cresult, spcol->column_width+1);
-    snprintf(cresult, SPART_MAX_COLUMN_SIZE, "%*s", spcol->column_width,
-             spcol->line2);
-    sp_strn2cat(line2, SPART_INFO_STRING_SIZE, cresult, spcol->column_width+1);
-    sp_strn2cat(line1, SPART_INFO_STRING_SIZE, " ", 2);
-    sp_strn2cat(line2, SPART_INFO_STRING_SIZE, " ", 2);
-  }
-}
-
-/* Prints visible Headers */
-void sp_headers_print(sp_headers_t *sph) {
-  char line1[SPART_INFO_STRING_SIZE];
-  char line2[SPART_INFO_STRING_SIZE];
-
-  line1[0] = 0;
-  line2[0] = 0;
-
-  sp_column_header_print(line1, line2, &(sph->hspace));
-#ifdef __slurmdb_cluster_rec_t_defined
-  sp_column_header_print(line1, line2, &(sph->cluster_name));
-#endif
-  sp_column_header_print(line1, line2, &(sph->partition_name));
-  sp_column_header_print(line1, line2, &(sph->partition_status));
-  sp_column_header_print(line1, line2, &(sph->free_cpu));
-  sp_column_header_print(line1, line2, &(sph->total_cpu));
-  sp_column_header_print(line1, line2, &(sph->waiting_resource));
-  sp_column_header_print(line1, line2, &(sph->waiting_other));
-  sp_column_header_print(line1, line2, &(sph->free_node));
-  sp_column_header_print(line1, line2, &(sph->total_node));
-  if (!(sph->hspace.visible)) {
-    sp_strn2cat(line1, SPART_INFO_STRING_SIZE, "|", 2);
-    sp_strn2cat(line2, SPART_INFO_STRING_SIZE, "|", 2);
+    sp_strbuf_right(line1, spcol->line1,
+                    strnlen(spcol->line1, spcol->column_width),
+                    spcol->column_width);
+    sp_strbuf_right(line2, spcol->line2,
+                    strnlen(spcol->line2, spcol->column_width),
+                    spcol->column_width);
+    sp_strbuf_catn(line1, " ", 1);
+    sp_strbuf_catn(line2, " ", 1);
   }
-  sp_column_header_print(line1, line2, &(sph->my_running));
-  sp_column_header_print(line1, line2, &(sph->my_waiting_resource));
-  sp_column_header_print(line1, line2, &(sph->my_waiting_other));
-  sp_column_header_print(line1, line2, &(sph->my_total));
-  if (!(sph->hspace.visible)) {
-    sp_strn2cat(line1, SPART_INFO_STRING_SIZE, "| ", 3);
-    sp_strn2cat(line2, SPART_INFO_STRING_SIZE, "| ", 3);
-  }
-  sp_column_header_print(line1, line2, &(sph->min_nodes));
-  sp_column_header_print(line1, line2, &(sph->max_nodes));
-  sp_column_header_print(line1, line2, &(sph->max_cpus_per_node));
-  sp_column_header_print(line1, line2, &(sph->def_mem_per_cpu));
-  sp_column_header_print(line1, line2, &(sph->max_mem_per_cpu));
-  sp_column_header_print(line1, line2, &(sph->djt_time));
-  sp_column_header_print(line1, line2, &(sph->mjt_time));
-  sp_column_header_print(line1, line2, &(sph->min_core));
-  sp_column_header_print(line1, line2, &(sph->min_mem_gb));
-  sp_column_header_print(line1, line2, &(sph->partition_qos));
-  sp_column_header_print(line1, line2, &(sph->gres));
-  sp_column_header_print(line1, line2, &(sph->features));
-  printf("%s\n%s\n", line1, line2);
 }
 
 /* Condensed printing for big numbers (k,m) */
-void sp_con_print(uint32_t num, uint16_t column_width) {
-  char cresult[SPART_MAX_COLUMN_SIZE];
+void sp_con_print(sp_strbuf_t *out, uint32_t num, uint16_t column_width) {
+  char cresult[24];
   uint16_t clong, cres;
-  snprintf(cresult, SPART_MAX_COLUMN_SIZE, "%d", num);
-  clong = strlen(cresult);
+  clong = sp_int_str(cresult, (int32_t)num);
   if (clong > column_width)
     cres = clong - column_width;
   else
@@ -297,41 +51,74 @@ void sp_con_print(uint32_t num, uint16_t column_width) {
   switch (cres) {
     case 1:
     case 2:
-      printf("%*d%s ", column_width - 1, (uint32_t)(num / 1000), "k");
+      sp_strbuf_int(out, (int32_t)(num / 1000), column_width - 1, ' ');
+      sp_strbuf_catn(out, "k ", 2);
       break;
 
     case 3:
-      printf("%*.1f%s ", column_width - 1, (float)(num / 1000000.0f), "m");
+      sp_strbuf_float1(out, (float)(num / 1000000.0f), column_width - 1);
+      sp_strbuf_catn(out, "m ", 2);
       break;
 
     case 4:
     case 5:
-      printf("%*d%s ", column_width - 1, (uint32_t)(num / 1000000), "m");
+      sp_strbuf_int(out, (int32_t)(num / 1000000), column_width - 1, ' ');
+      sp_strbuf_catn(out, "m ", 2);
       break;
 
     case 6:
-      printf("%*.1f%s ", column_width - 1, (float)(num / 1000000000.0f), "g");
+      sp_strbuf_float1(out, (float)(num / 1000000000.0f), column_width - 1);
+      sp_strbuf_catn(out, "g ", 2);
       break;
 
     case 7:
     case 8:
-      printf("%*d%s ", column_width - 1, (uint32_t)(num / 1000000000), "g");
+      sp_strbuf_int(out, (int32_t)(num / 1000000000), column_width - 1, ' ');
+      sp_strbuf_catn(out, "g ", 2);
       break;
 
     default:
-      printf("%*d ", column_width, num);
+      sp_strbuf_right(out, cresult, clong, column_width);
+      sp_strbuf_catn(out, " ", 1);
   }
 }
 
+/* Adds the number and the unit to the date string, which can hold at most
+ * max chars. Returns the new length. */
+size_t sp_date_cat(char *str, size_t len, size_t max, uint16_t num,
+                   const char *unit) {
+  char ctmp[SPART_MAX_COLUMN_SIZE];
+  size_t n = sp_int_str(ctmp, num);
+
+  memcpy(ctmp + n, unit, strlen(unit) + 1);
+  n += strlen(unit);
+  if (len > max) len = max;
+  if (n > max - len) n = max - len;
+  memcpy(str + len, ctmp, n);
+  len += n;
+  str[len] = 0;
+  return len;
+}
+
+/* Adds the time as "D-HH:MM " */
+void sp_date_short_print(sp_strbuf_t *out, uint16_t tday, uint16_t thour,
+                         uint16_t tminute) {
+  sp_strbuf_int(out, tday, 4, ' ');
+  sp_strbuf_catn(out, "-", 1);
+  sp_strbuf_int(out, thour, 2, '0');
+  sp_strbuf_catn(out, ":", 1);
+  sp_strbuf_int(out, tminute, 2, '0');
+  sp_strbuf_catn(out, " ", 1);
+}
+
 /* Date printing */
-void sp_date_print(uint32_t time_to_show, uint16_t column_width,
-                   int show_as_date) {
+void sp_date_print(sp_strbuf_t *out, uint32_t time_to_show,
+                   uint16_t column_width, int show_as_date) {
   uint16_t tday;
   uint16_t thour;
   uint16_t tminute;
-  int len;
+  size_t len = 0;
   char cresult[SPART_MAX_COLUMN_SIZE];
-  char ctmp[SPART_MAX_COLUMN_SIZE];
 
   cresult[0] = '\0';
 
@@ -339,87 +126,44 @@ void sp_date_print(uint32_t time_to_show, uint16_t column_width,
   thour = (time_to_show - (tday * 1440)) / 60;
   tminute = time_to_show - (tday * 1440) - (thour * (uint16_t)60);
 
-  if (show_as_date == 0) {
-    if ((time_to_show == INFINITE) || (time_to_show == NO_VAL))
-      printf("    -      ");
-    else {
-      if (tday != 0) {
-        snprintf(cresult, SPART_MAX_COLUMN_SIZE, "%d days ", tday);
-      }
-      if (thour != 0) {
-        snprintf(ctmp, SPART_MAX_COLUMN_SIZE, "%d hour ", thour);
-        sp_strn2cat(cresult, column_width, ctmp, column_width+1);
-      }
-      if (tminute != 0) {
-        snprintf(ctmp, SPART_MAX_COLUMN_SIZE, "%d mins ", tminute);
-        sp_strn2cat(cresult, column_width, ctmp, column_width+1);
-      }
-      len = strlen(cresult);
+  if ((time_to_show == INFINITE) || (time_to_show == NO_VAL)) {
+    sp_strbuf_catn(out, "    -      ", 11);
+  } else if (show_as_date == 0) {
+    if (tday != 0)
+      len = sp_date_cat(cresult, len, SPART_MAX_COLUMN_SIZE - 1, tday,
+                        " days ");
+    /* the hours and the minutes are cut to the column width */
+    if (thour != 0)
+      len = sp_date_cat(cresult, len, column_width - 1, thour, " hour ");
+    if (tminute != 0)
+      len = sp_date_cat(cresult, len, column_width - 1, tminute, " mins ");
+    if (len < column_width) {
       /* delete last space */
-      cresult[len - 1] = '\0';
-      if (len < column_width)
-        printf("%10s ", cresult);
-      else
-        printf("%4d-%02d:%02d ", tday, thour, tminute);
-    }
+      if (len > 0) len--;
+      sp_strbuf_right(out, cresult, len, 10);
+      sp_strbuf_catn(out, " ", 1);
+    } else
+      sp_date_short_print(out, tday, thour, tminute);
   } else {
-    if ((time_to_show == INFINITE) || (time_to_show == NO_VAL))
-      printf("    -      ");
-    else {
-      printf("%4d-%02d:%02d ", tday, thour, tminute);
-    }
-  }
-}
-
-/* Condensed printing for big numbers (k,m) to the string */
-void sp_con_strprint(char *str, uint16_t size, uint32_t num) {
-  char cresult[SPART_MAX_COLUMN_SIZE];
-  snprintf(cresult, SPART_MAX_COLUMN_SIZE, "%d", num);
-  switch (strlen(cresult)) {
-    case 5:
-    case 6:
-      snprintf(str, size, "%d%s", (uint32_t)(num / 1000), "k");
-      break;
-
-    case 7:
-      snprintf(str, size, "%.1f%s", (float)(num / 1000000.0f), "m");
-      break;
-
-    case 8:
-    case 9:
-      snprintf(str, size, "%d%s", (uint32_t)(num / 1000000), "m");
-      break;
-
-    case 10:
-      snprintf(str, size, "%.1f%s", (float)(num / 1000000000.0f), "g");
-      break;
-
-    case 11:
-    case 12:
-      snprintf(str, size, "%d%s", (uint32_t)(num / 1000000000), "g");
-      break;
-
-    default:
-      snprintf(str, size, "%d", num);
+    sp_date_short_print(out, tday, thour, tminute);
   }
 }
 
-/* Prints a horizontal separetor such as ======= */
-void sp_seperator_print(const char ch, const int count) {
-  int x;
-  for (x = 0; x < count; x++) printf("%c", ch);
+/* Adds a horizontal separetor such as ======= */
+void sp_seperator_print(sp_strbuf_t *out, const char ch, const int count) {
+  if (count > 0) sp_strbuf_pad(out, ch, count);
 }
 
 #ifdef SPART_SHOW_STATEMENT
-void sp_statement_print(const char *stfile, const char *stpartition,
-                        const int total_width) {
+void sp_statement_print(sp_strbuf_t *out, const char *stfile,
+                        const char *stpartition, const int total_width) {
 
   char re_str[SPART_INFO_STRING_SIZE];
   FILE *fo;
   int m, k;
   fo = fopen(stfile, "r");
   if (fo) {
-    printf("\n");
+    sp_strbuf_cat(out, "\n");
     while (fgets(re_str, SPART_INFO_STRING_SIZE, fo)) {
       /* To correctly frame some wide chars, but not all */
       m = 0;
@@ -427,149 +171,805 @@ void sp_statement_print(const char *stfile, const char *stpartition,
         if ((re_str[k] < -58) && (re_str[k] > -62)) m++;
         if (re_str[k] == '\n') re_str[k] = '\0';
       }
-      printf("  %s %-*s %s\n", SPART_STATEMENT_QUEUE_LINEPRE, 92 + m, re_str,
-             SPART_STATEMENT_QUEUE_LINEPOST);
+      sp_strbuf_printf(out, "  %s %-*s %s\n", SPART_STATEMENT_QUEUE_LINEPRE,
+                       92 + m, re_str, SPART_STATEMENT_QUEUE_LINEPOST);
     }
-    printf("  %s ", SPART_STATEMENT_QUEUE_LINEPRE);
-    sp_seperator_print('-', total_width);
-    printf(" %s\n\n", SPART_STATEMENT_QUEUE_LINEPOST);
+    sp_strbuf_printf(out, "  %s ", SPART_STATEMENT_QUEUE_LINEPRE);
+    sp_seperator_print(out, '-', total_width);
+    sp_strbuf_printf(out, " %s\n\n", SPART_STATEMENT_QUEUE_LINEPOST);
     pclose(fo);
   } else {
-    printf("  %s ", SPART_STATEMENT_QUEUE_LINEPRE);
-    sp_seperator_print('-', total_width);
-    printf(" %s\n", SPART_STATEMENT_QUEUE_LINEPOST);
+    sp_strbuf_printf(out, "  %s ", SPART_STATEMENT_QUEUE_LINEPRE);
+    sp_seperator_print(out, '-', total_width);
+    sp_strbuf_printf(out, " %s\n", SPART_STATEMENT_QUEUE_LINEPOST);
   }
 }
 #endif
 
-/* Prints a partition info */
-void sp_partition_print(sp_part_info_t *sp, sp_headers_t *sph, int show_max_mem,
-                        int show_as_date, int total_width) {
-  char mem_result[SPART_INFO_STRING_SIZE];
-  if (sp->visible) {
-    if (sph->hspace.visible)
-      printf("%*s ", sph->hspace.column_width, "COMMON VALUES:");
+/* Adds a string column to the output, right aligned */
+void sp_column_str_print(sp_strbuf_t *out, const char *str,
+                         uint16_t column_width) {
+  sp_strbuf_right(out, str, strlen(str), column_width);
+  sp_strbuf_catn(out, " ", 1);
+}
+
+/* Adds a number column to the output, without condensing */
+void sp_con_str_int(sp_strbuf_t *out, uint32_t num, uint16_t column_width) {
+  sp_strbuf_int(out, (int32_t)num, column_width, ' ');
+  sp_strbuf_catn(out, " ", 1);
+}
+
+/* Adds a "min-max" column to the output */
+void sp_range_print(sp_strbuf_t *out, uint32_t min, uint32_t max,
+                    uint16_t column_width) {
+  char str[56];
+  size_t n = sp_int_str(str, (int32_t)min);
+  str[n++] = '-';
+  n += sp_int_str(str + n, (int32_t)max);
+  sp_strbuf_right(out, str, n, column_width);
+  sp_strbuf_catn(out, " ", 1);
+}
+
+/* An output column. Its value is at the value offset of the sp_part_info_t,
+ * and its header is at the same index of the sp_headers_t. */
+typedef struct sp_column {
+  const char *name;
+  size_t value;
+  uint16_t value_size;
+  /* the max of a "min-max" column */
+  size_t value2;
+  uint16_t value2_size;
+  /* SPART_COLUMN_ kind, and SPART_GROUP_ group */
+  uint16_t kind;
+  uint16_t group;
+  /* SPART_RULE_ bits, the SPART_SET_ bit of a limit, and the SPART_PLAN_
+   * bits which compute the column */
+  uint16_t rules;
+  uint16_t limit;
+  uint16_t plan;
+  /* the seperator before the column, if there is no COMMON VALUES label */
+  const char *before;
+  /* the default header, and the width when the max is shown */
+  const char *line1;
+  const char *line2;
+  uint16_t column_width;
+  uint16_t long_width;
+  uint16_t visible;
+  /* returns 0, if the column values of the partitions are same */
+  int (*compare)(const struct sp_column *col, const sp_part_info_t *a,
+                 const sp_part_info_t *b, const sp_strpool_t *strs,
+                 int flags);
+  /* adds the column value of the partition to the output */
+  void (*print)(sp_strbuf_t *out, const struct sp_column *col,
+                const sp_part_info_t *sp, const sp_strpool_t *strs,
+                uint16_t column_width, int flags);
+  /* adds the exact column value of the partition to the JSON object */
+  void (*json)(sp_json_t *js, const struct sp_column *col,
+               const sp_part_info_t *sp, const sp_strpool_t *strs);
+  /* the JSON key, if it is not the name */
+  const char *key;
+} sp_column_t;
+
+/* Returns the JSON key of the column */
+const char *sp_column_key(const sp_column_t *col) {
+  return (col->key != NULL) ? col->key : col->name;
+}
+
+/* Returns the number at the offset of the partition info */
+uint64_t sp_column_num(const sp_part_info_t *sp, size_t offset,
+                       uint16_t size) {
+  const char *p = (const char *)sp + offset;
+  switch (size) {
+    case sizeof(uint16_t):
+      return *(const uint16_t *)p;
+    case sizeof(uint32_t):
+      return *(const uint32_t *)p;
+    default:
+      return *(const uint64_t *)p;
+  }
+}
+
+/* Returns the pooled string at the offset of the partition info */
+const char *sp_column_str(const sp_part_info_t *sp, const sp_strpool_t *strs,
+                          size_t offset) {
+  return sp_str(strs, *(const uint32_t *)((const char *)sp + offset));
+}
+
+int sp_column_num_cmp(const sp_column_t *col, const sp_part_info_t *a,
+                      const sp_part_info_t *b, const sp_strpool_t *strs,
+                      int flags) {
+  if (sp_column_num(a, col->value, col->value_size) !=
+      sp_column_num(b, col->value, col->value_size))
+    return 1;
+  /* the max is compared, only if it is shown */
+  if ((col->value2_size != 0) && (flags & SPART_PRINT_MAX_MEM))
+    return sp_column_num(a, col->value2, col->value2_size) !=
+           sp_column_num(b, col->value2, col->value2_size);
+  return 0;
+}
+
+/* The memory is kept as MB, and it is shown as GB */
+uint64_t sp_column_gb(const sp_part_info_t *sp, size_t offset,
+                      uint16_t size) {
+  return sp_column_num(sp, offset, size) / 1000u;
+}
+
+int sp_column_mem_cmp(const sp_column_t *col, const sp_part_info_t *a,
+                      const sp_part_info_t *b, const sp_strpool_t *strs,
+                      int flags) {
+  if (sp_column_gb(a, col->value, col->value_size) !=
+      sp_column_gb(b, col->value, col->value_size))
+    return 1;
+  if ((col->value2_size != 0) && (flags & SPART_PRINT_MAX_MEM))
+    return sp_column_gb(a, col->value2, col->value2_size) !=
+           sp_column_gb(b, col->value2, col->value2_size);
+  return 0;
+}
+
+int sp_column_str_cmp(const sp_column_t *col, const sp_part_info_t *a,
+                      const sp_part_info_t *b, const sp_strpool_t *strs,
+                      int flags) {
+  return strcmp(sp_column_str(a, strs, col->value),
+                sp_column_str(b, strs, col->value)) != 0;
+}
+
+void sp_column_label_print(sp_strbuf_t *out, const sp_column_t *col,
+                           const sp_part_info_t *sp, const sp_strpool_t *strs,
+                           uint16_t column_width, int flags) {
+  sp_column_str_print(out, "COMMON VALUES:", column_width);
+}
+
+void sp_column_name_print(sp_strbuf_t *out, const sp_column_t *col,
+                          const sp_part_info_t *sp, const sp_strpool_t *strs,
+                          uint16_t column_width, int flags) {
+  sp_column_str_print(out, sp_column_str(sp, strs, col->value), column_width);
+}
+
+void sp_column_chars_print(sp_strbuf_t *out, const sp_column_t *col,
+                           const sp_part_info_t *sp, const sp_strpool_t *strs,
+                           uint16_t column_width, int flags) {
+  sp_column_str_print(out, (const char *)sp + col->value, column_width);
+}
+
+/* Gres and features lists are left aligned */
+void sp_column_list_print(sp_strbuf_t *out, const sp_column_t *col,
+                          const sp_part_info_t *sp, const sp_strpool_t *strs,
+                          uint16_t column_width, int flags) {
+  const char *str = sp_column_str(sp, strs, col->value);
+  sp_strbuf_left(out, str, strlen(str), column_width);
+  sp_strbuf_catn(out, " ", 1);
+}
+
+void sp_column_con_print(sp_strbuf_t *out, const sp_column_t *col,
+                         const sp_part_info_t *sp, const sp_strpool_t *strs,
+                         uint16_t column_width, int flags) {
+  sp_con_print(out, sp_column_num(sp, col->value, col->value_size),
+               column_width);
+}
+
+/* An unlimited value is shown as "-" */
+void sp_column_max_print(sp_strbuf_t *out, const sp_column_t *col,
+                         const sp_part_info_t *sp, const sp_strpool_t *strs,
+                         uint16_t column_width, int flags) {
+  uint64_t num = sp_column_num(sp, col->value, col->value_size);
+  if (num == UINT_MAX)
+    sp_column_str_print(out, "-", column_width);
+  else
+    sp_con_print(out, num, column_width);
+}
+
+/* An unlimited or unset value is shown as "-" */
+void sp_column_limit_print(sp_strbuf_t *out, const sp_column_t *col,
+                           const sp_part_info_t *sp, const sp_strpool_t *strs,
+                           uint16_t column_width, int flags) {
+  uint64_t num = sp_column_num(sp, col->value, col->value_size);
+  if ((num == UINT_MAX) || (num == 0))
+    sp_column_str_print(out, "-", column_width);
+  else
+    sp_con_print(out, num, column_width);
+}
+
+/* An unlimited or unset memory limit is shown as "-" */
+void sp_column_mem_print(sp_strbuf_t *out, const sp_column_t *col,
+                         const sp_part_info_t *sp, const sp_strpool_t *strs,
+                         uint16_t column_width, int flags) {
+  uint64_t num = sp_column_num(sp, col->value, col->value_size);
+  if ((num >= UINT_MAX) || (num / 1000u == 0))
+    sp_column_str_print(out, "-", column_width);
+  else
+    sp_con_print(out, num / 1000u, column_width);
+}
+
+void sp_column_time_print(sp_strbuf_t *out, const sp_column_t *col,
+                          const sp_part_info_t *sp, const sp_strpool_t *strs,
+                          uint16_t column_width, int flags) {
+  sp_date_print(out, sp_column_num(sp, col->value, col->value_size),
+                column_width, (flags & SPART_PRINT_AS_DATE) != 0);
+}
+
+/* The max is shown, only if it is wanted and differs from the min */
+void sp_column_range_print(sp_strbuf_t *out, const sp_column_t *col,
+                           const sp_part_info_t *sp, const sp_strpool_t *strs,
+                           uint16_t column_width, int flags) {
+  uint32_t min = sp_column_num(sp, col->value, col->value_size);
+  uint32_t max = sp_column_num(sp, col->value2, col->value2_size);
+  if ((flags & SPART_PRINT_MAX_MEM) && (min != max))
+    sp_range_print(out, min, max, column_width);
+  else
+    sp_con_str_int(out, min, column_width);
+}
+
+/* The same as the range, with the memory as GB */
+void sp_column_mem_range_print(sp_strbuf_t *out, const sp_column_t *col,
+                               const sp_part_info_t *sp,
+                               const sp_strpool_t *strs, uint16_t column_width,
+                               int flags) {
+  uint32_t min = sp_column_gb(sp, col->value, col->value_size);
+  uint32_t max = sp_column_gb(sp, col->value2, col->value2_size);
+  if ((flags & SPART_PRINT_MAX_MEM) && (min != max))
+    sp_range_print(out, min, max, column_width);
+  else
+    sp_con_str_int(out, min, column_width);
+}
+
+void sp_column_str_json(sp_json_t *js, const sp_column_t *col,
+                        const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  sp_json_str(js, sp_column_str(sp, strs, col->value));
+}
+
+void sp_column_chars_json(sp_json_t *js, const sp_column_t *col,
+                          const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  sp_json_str(js, (const char *)sp + col->value);
+}
+
+void sp_column_num_json(sp_json_t *js, const sp_column_t *col,
+                        const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  sp_json_int(js, sp_column_num(sp, col->value, col->value_size));
+}
+
+/* An unlimited value is null */
+void sp_column_max_json(sp_json_t *js, const sp_column_t *col,
+                        const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  uint64_t num = sp_column_num(sp, col->value, col->value_size);
+  if (num == UINT_MAX)
+    sp_json_null(js);
+  else
+    sp_json_int(js, num);
+}
+
+/* An unlimited or unset value is null */
+void sp_column_limit_json(sp_json_t *js, const sp_column_t *col,
+                          const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  uint64_t num = sp_column_num(sp, col->value, col->value_size);
+  if ((num == UINT_MAX) || (num == 0))
+    sp_json_null(js);
+  else
+    sp_json_int(js, num);
+}
+
+/* The memory limit is given as MB, an unlimited or unset limit is null */
+void sp_column_mem_json(sp_json_t *js, const sp_column_t *col,
+                        const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  uint64_t num = sp_column_num(sp, col->value, col->value_size);
+  if ((num >= UINT_MAX) || (num == 0))
+    sp_json_null(js);
+  else
+    sp_json_int(js, num);
+}
+
+/* The time is given as minutes, an unlimited time is null */
+void sp_column_time_json(sp_json_t *js, const sp_column_t *col,
+                         const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  uint32_t num = sp_column_num(sp, col->value, col->value_size);
+  if ((num == INFINITE) || (num == NO_VAL))
+    sp_json_null(js);
+  else
+    sp_json_int(js, num);
+}
+
+/* The min is the column value, and the max is added as key_max */
+void sp_column_range_json(sp_json_t *js, const sp_column_t *col,
+                          const sp_part_info_t *sp, const sp_strpool_t *strs) {
+  char key[SPART_MAX_COLUMN_SIZE];
+  sp_json_int(js, sp_column_num(sp, col->value, col->value_size));
+  snprintf(key, SPART_MAX_COLUMN_SIZE, "%s_max", sp_column_key(col));
+  sp_json_key(js, key);
+  sp_json_int(js, sp_column_num(sp, col->value2, col->value2_size));
+}
+
+#define SPART_VALUE(field) \
+  offsetof(sp_part_info_t, field), sizeof(((sp_part_info_t *)0)->field)
+#define SPART_NO_VALUE 0, 0
+#define SPART_SHOWN (SPART_RULE_LONG | SPART_RULE_DETAIL)
+#define SPART_LIMIT (SPART_RULE_LONG | SPART_RULE_DETAIL | SPART_RULE_LIMIT)
+
+/* The output columns, in the printing order */
+const sp_column_t sp_columns[SPART_COLUMN_COUNT] = {
+    [SPART_COL_LABEL] = {"label", SPART_NO_VALUE, SPART_NO_VALUE,
+                         SPART_COLUMN_LABEL, SPART_GROUP_NONE, 0, 0, 0, NULL,
+                         "           ", "           ", 17, 0, 0, NULL,
+                         sp_column_label_print, NULL},
 #ifdef __slurmdb_cluster_rec_t_defined
-    if (sph->cluster_name.visible)
-      printf("%*s ", sph->cluster_name.column_width, sp->cluster_name);
+    [SPART_COL_CLUSTER] = {"cluster", SPART_VALUE(cluster_name),
+                           SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                           SPART_GROUP_NONE, 0, 0, 0, NULL, " CLUSTER",
+                           "    NAME", 8, 0, 0, sp_column_str_cmp,
+                           sp_column_name_print, sp_column_str_json},
 #endif
-    if (sph->partition_name.visible)
-      printf("%*s ", sph->partition_name.column_width, sp->partition_name);
-    if (sph->partition_status.visible)
-      printf("%*s ", sph->partition_status.column_width, sp->partition_status);
-    if (sph->free_cpu.visible)
-      sp_con_print(sp->free_cpu, sph->free_cpu.column_width);
-    if (sph->total_cpu.visible)
-      sp_con_print(sp->total_cpu, sph->total_cpu.column_width);
-    if (sph->waiting_resource.visible)
-      sp_con_print(sp->waiting_resource, sph->waiting_resource.column_width);
-    if (sph->waiting_other.visible)
-      sp_con_print(sp->waiting_other, sph->waiting_other.column_width);
-    if (sph->free_node.visible)
-      sp_con_print(sp->free_node, sph->free_node.column_width);
-    if (sph->total_cpu.visible)
-      sp_con_print(sp->total_node, sph->total_cpu.column_width);
-    if (!(sph->hspace.visible)) printf("|");
-    if (sph->my_running.visible)
-      sp_con_print(sp->my_running, sph->my_running.column_width);
-    if (sph->my_waiting_resource.visible)
-      sp_con_print(sp->my_waiting_resource,
-                   sph->my_waiting_resource.column_width);
-    if (sph->my_waiting_other.visible)
-      sp_con_print(sp->my_waiting_other, sph->my_waiting_other.column_width);
-    if (sph->my_total.visible)
-      sp_con_print(sp->my_total, sph->my_total.column_width);
-    if (!(sph->hspace.visible)) printf("| ");
-    if (sph->min_nodes.visible)
-      sp_con_print(sp->min_nodes, sph->min_nodes.column_width);
-    if (sph->max_nodes.visible) {
-      if (sp->max_nodes == UINT_MAX)
-        printf("%*s ", sph->max_nodes.column_width, "-");
-      else
-        sp_con_print(sp->max_nodes, sph->max_nodes.column_width);
-    }
-    if (sph->max_cpus_per_node.visible) {
-      if ((sp->max_cpus_per_node == UINT_MAX) || (sp->max_cpus_per_node == 0))
-        printf("%*s ", sph->max_cpus_per_node.column_width, "-");
-      else
-        sp_con_print(sp->max_cpus_per_node,
-                     sph->max_cpus_per_node.column_width);
-    }
-    if (sph->def_mem_per_cpu.visible) {
-      if ((sp->def_mem_per_cpu == UINT_MAX) || (sp->def_mem_per_cpu == 0))
-        printf("%*s ", sph->def_mem_per_cpu.column_width, "-");
-      else
-        sp_con_print(sp->def_mem_per_cpu, sph->def_mem_per_cpu.column_width);
-    }
-    if (sph->max_mem_per_cpu.visible) {
-      if ((sp->max_mem_per_cpu == UINT_MAX) || (sp->max_mem_per_cpu == 0))
-        printf("%*s ", sph->max_mem_per_cpu.column_width, "-");
-      else
-        sp_con_print(sp->max_mem_per_cpu, sph->max_mem_per_cpu.column_width);
+    [SPART_COL_PARTITION] = {"partition", SPART_VALUE(partition_name),
+                             SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                             SPART_GROUP_NONE, SPART_RULE_LONG, 0, 0, NULL,
+                             "     QUEUE", " PARTITION", 10, 0, 1, NULL,
+                             sp_column_name_print, sp_column_str_json},
+    [SPART_COL_STATUS] = {"status", SPART_VALUE(partition_status),
+                          SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                          SPART_GROUP_NONE, SPART_RULE_LONG, 0, 0, NULL,
+                          "STA", "TUS", 3, 0, 1, NULL, sp_column_chars_print,
+                          sp_column_chars_json},
+    [SPART_COL_FREE_CORES] = {"free_cores", SPART_VALUE(free_cpu),
+                              SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                              SPART_GROUP_NONE, SPART_RULE_LONG, 0,
+                              SPART_PLAN_NODES, NULL, "  FREE", " CORES", 6,
+                              0, 1, NULL, sp_column_con_print,
+                              sp_column_num_json},
+    [SPART_COL_TOTAL_CORES] = {"total_cores", SPART_VALUE(total_cpu),
+                               SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                               SPART_GROUP_NONE, SPART_RULE_LONG, 0, 0, NULL,
+                               " TOTAL", " CORES", 6, 0, 1, NULL,
+                               sp_column_con_print, sp_column_num_json},
+    [SPART_COL_RESOURCE_PENDING] = {"resource_pending",
+                                    SPART_VALUE(waiting_resource),
+                                    SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                                    SPART_GROUP_NONE, SPART_RULE_LONG, 0,
+                                    SPART_PLAN_WAITING, NULL, "RESORC",
+                                    "PENDNG", 6, 0, 1, NULL,
+                                    sp_column_con_print, sp_column_num_json},
+    [SPART_COL_OTHER_PENDING] = {"other_pending", SPART_VALUE(waiting_other),
+                                 SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                                 SPART_GROUP_NONE, SPART_RULE_LONG, 0,
+                                 SPART_PLAN_WAITING, NULL, " OTHER", "PENDNG",
+                                 6, 0, 1, NULL, sp_column_con_print,
+                                 sp_column_num_json},
+    [SPART_COL_FREE_NODES] = {"free_nodes", SPART_VALUE(free_node),
+                              SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                              SPART_GROUP_NONE, SPART_RULE_LONG, 0,
+                              SPART_PLAN_NODES, NULL, "  FREE", " NODES", 6,
+                              0, 1, NULL, sp_column_con_print,
+                              sp_column_num_json},
+    [SPART_COL_TOTAL_NODES] = {"total_nodes", SPART_VALUE(total_node),
+                               SPART_NO_VALUE, SPART_COLUMN_FIXED,
+                               SPART_GROUP_NONE, SPART_RULE_LONG, 0, 0, NULL,
+                               " TOTAL", " NODES", 6, 0, 1, NULL,
+                               sp_column_con_print, sp_column_num_json},
+    [SPART_COL_MY_RUNNING] = {"my_running", SPART_VALUE(my_running),
+                              SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                              SPART_GROUP_MY_JOBS, SPART_RULE_LONG, 0,
+                              SPART_PLAN_MY_JOBS, "|", "YOUR", " RUN", 4, 0,
+                              1, sp_column_num_cmp, sp_column_con_print,
+                              sp_column_num_json},
+    [SPART_COL_MY_RESOURCE_PENDING] = {"my_resource_pending",
+                                       SPART_VALUE(my_waiting_resource),
+                                       SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                                       SPART_GROUP_MY_JOBS, SPART_RULE_LONG,
+                                       0, SPART_PLAN_MY_JOBS, NULL, "PEND",
+                                       " RES", 4, 0, 1, sp_column_num_cmp,
+                                       sp_column_con_print,
+                                       sp_column_num_json},
+    [SPART_COL_MY_OTHER_PENDING] = {"my_other_pending",
+                                    SPART_VALUE(my_waiting_other),
+                                    SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                                    SPART_GROUP_MY_JOBS, SPART_RULE_LONG, 0,
+                                    SPART_PLAN_MY_JOBS, NULL, "PEND", "OTHR",
+                                    4, 0, 1, sp_column_num_cmp,
+                                    sp_column_con_print, sp_column_num_json},
+    [SPART_COL_MY_TOTAL] = {"my_total", SPART_VALUE(my_total),
+                            SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                            SPART_GROUP_MY_JOBS, SPART_RULE_LONG, 0,
+                            SPART_PLAN_MY_JOBS, NULL, "YOUR", "TOTL", 4, 0, 1,
+                            sp_column_num_cmp, sp_column_con_print,
+                            sp_column_num_json},
+    [SPART_COL_MIN_NODES] = {"min_nodes", SPART_VALUE(min_nodes),
+                             SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                             SPART_GROUP_NONE, SPART_LIMIT,
+                             SPART_SET_MIN_NODES, 0, "| ", "  MIN", "NODES",
+                             5, 0, 1, sp_column_num_cmp, sp_column_con_print,
+                             sp_column_num_json},
+    [SPART_COL_MAX_NODES] = {"max_nodes", SPART_VALUE(max_nodes),
+                             SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                             SPART_GROUP_NONE, SPART_LIMIT,
+                             SPART_SET_MAX_NODES, 0, NULL, "  MAX", "NODES",
+                             5, 0, 1, sp_column_num_cmp, sp_column_max_print,
+                             sp_column_max_json},
+    [SPART_COL_MAX_CPUS_PER_NODE] = {"max_cpus_per_node",
+                                     SPART_VALUE(max_cpus_per_node),
+                                     SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                                     SPART_GROUP_NONE, SPART_LIMIT,
+                                     SPART_SET_MAX_CPUS_PER_NODE, 0, NULL,
+                                     "MAXCPU", " /NODE", 6, 0, 0,
+                                     sp_column_num_cmp, sp_column_limit_print,
+                                     sp_column_limit_json},
+    [SPART_COL_DEF_MEM] = {"def_mem", SPART_VALUE(def_mem_per_cpu),
+                           SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                           SPART_GROUP_NONE, SPART_LIMIT,
+                           SPART_SET_DEF_MEM_PER_CPU, 0, NULL, "DEFMEM",
+                           "GB/CPU", 6, 0, 0, sp_column_mem_cmp,
+                           sp_column_mem_print, sp_column_mem_json,
+                           "def_mem_mb"},
+    [SPART_COL_MAX_MEM] = {"max_mem", SPART_VALUE(max_mem_per_cpu),
+                           SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                           SPART_GROUP_NONE, SPART_LIMIT,
+                           SPART_SET_MAX_MEM_PER_CPU, 0, NULL, "MAXMEM",
+                           "GB/CPU", 6, 0, 0, sp_column_mem_cmp,
+                           sp_column_mem_print, sp_column_mem_json,
+                           "max_mem_mb"},
+    [SPART_COL_DEF_TIME] = {"def_time", SPART_VALUE(djt_time),
+                            SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                            SPART_GROUP_NONE, SPART_LIMIT, SPART_SET_DJT_TIME,
+                            0, NULL, "   DEFAULT", "  JOB-TIME", 10, 0, 0,
+                            sp_column_num_cmp, sp_column_time_print,
+                            sp_column_time_json},
+    [SPART_COL_MAX_TIME] = {"max_time", SPART_VALUE(mjt_time),
+                            SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                            SPART_GROUP_NONE, SPART_LIMIT, SPART_SET_MJT_TIME,
+                            0, NULL, "   MAXIMUM", "  JOB-TIME", 10, 0, 1,
+                            sp_column_num_cmp, sp_column_time_print,
+                            sp_column_time_json},
+    [SPART_COL_CORES] = {"cores", SPART_VALUE(min_core),
+                         SPART_VALUE(max_core), SPART_COLUMN_COMMON,
+                         SPART_GROUP_NONE, SPART_SHOWN, 0,
+                         SPART_PLAN_NODE_LIMITS, NULL, " CORES", " /NODE", 6,
+                         8, 1, sp_column_num_cmp, sp_column_range_print,
+                         sp_column_range_json},
+    [SPART_COL_NODE_MEM] = {"node_mem", SPART_VALUE(min_mem_mb),
+                            SPART_VALUE(max_mem_mb), SPART_COLUMN_COMMON,
+                            SPART_GROUP_NONE, SPART_SHOWN, 0,
+                            SPART_PLAN_NODE_LIMITS, NULL, "  NODE", "MEM-GB",
+                            6, 10, 1, sp_column_mem_cmp,
+                            sp_column_mem_range_print, sp_column_range_json,
+                            "node_mem_mb"},
+    [SPART_COL_QOS] = {"qos", SPART_VALUE(partition_qos), SPART_NO_VALUE,
+                       SPART_COLUMN_COMMON, SPART_GROUP_NONE, SPART_LIMIT,
+                       SPART_SET_PARTITION_QOS, SPART_PLAN_QOS, NULL,
+                       "   QOS", "  NAME", 6, 0, 1, sp_column_str_cmp,
+                       sp_column_name_print, sp_column_str_json},
+    [SPART_COL_GRES] = {"gres", SPART_VALUE(gres), SPART_NO_VALUE,
+                        SPART_COLUMN_COMMON, SPART_GROUP_NONE, SPART_SHOWN, 0,
+                        SPART_PLAN_GRES, NULL, " GRES       ", "(NODE-COUNT)",
+                        12, 0, 0, sp_column_str_cmp, sp_column_list_print,
+                        sp_column_str_json},
+    [SPART_COL_FEATURES] = {"features", SPART_VALUE(features),
+                            SPART_NO_VALUE, SPART_COLUMN_COMMON,
+                            SPART_GROUP_NONE, SPART_RULE_DETAIL, 0,
+                            SPART_PLAN_FEATURES, NULL, " FEATURES   ",
+                            "(NODE-COUNT)", 12, 0, 0, sp_column_str_cmp,
+                            sp_column_list_print, sp_column_str_json}};
+
+/* Initialize all column headers */
+void sp_headers_set_defaults(sp_headers_t *sph) {
+  sp_column_header_t *h;
+  size_t c;
+
+  memset(sph, 0, sizeof(sp_headers_t));
+  for (c = 0; c < SPART_COLUMN_COUNT; c++) {
+    h = &(sph->col[c]);
+    h->line1 = sp_columns[c].line1;
+    h->line2 = sp_columns[c].line2;
+    h->column_width = sp_columns[c].column_width;
+    h->visible = sp_columns[c].visible;
+    sph->order[c] = c;
+  }
+  sph->order_count = SPART_COLUMN_COUNT;
+}
+
+/* Widens the "min-max" columns, to show the max values */
+void sp_headers_set_long_width(sp_headers_t *sph) {
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    if (sp_columns[c].long_width)
+      sph->col[c].column_width = sp_columns[c].long_width;
+}
+
+/* Sets the columns of the -l parameter as visible */
+void sp_headers_set_parameter_L(sp_headers_t *sph) {
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    if (sp_columns[c].kind != SPART_COLUMN_LABEL)
+      sph->col[c].visible = (sp_columns[c].rules & SPART_RULE_LONG) != 0;
+  sp_headers_set_long_width(sph);
+}
+
+/* Hides the columns, which have the SPART_RULE_ rule */
+void sp_headers_hide_rule(sp_headers_t *sph, uint16_t rule) {
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    if (sp_columns[c].rules & rule) sph->col[c].visible = 0;
+}
+
+/* Shows or hides the columns of a SPART_GROUP_ group */
+void sp_headers_set_group(sp_headers_t *sph, uint16_t group,
+                          uint16_t visible) {
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    if (sp_columns[c].group == group) sph->col[c].visible = visible;
+}
+
+/* Shows the limit columns, only if a partition sets their limits. The
+ * limits are the SPART_SET_ bits of the partitions. */
+void sp_headers_hide_unset(sp_headers_t *sph, uint16_t limits) {
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    if (sp_columns[c].rules & SPART_RULE_LIMIT)
+      sph->col[c].visible = (limits & sp_columns[c].limit) != 0;
+}
+
+/* Finds the slurm requests and the computations, which are needed by the
+ * visible columns. The columns, which are shown only if their values are
+ * not at defaults, should be visible here to be computed. */
+void sp_plan_make(sp_plan_t *plan, sp_headers_t *sph) {
+  size_t c;
+
+  plan->compute = 0;
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    if (sph->col[c].visible) plan->compute |= sp_columns[c].plan;
+  sp_plan_set_wanted(plan);
+}
+
+/* Sets the visible columns and their order from a list such as
+ * "partition,free_cores:8,qos". The width after the colon is optional.
+ * Returns 0, and prints the reason if the list is not valid. */
+int sp_headers_set_format(sp_headers_t *sph, const char *format) {
+  const char *cursor = format;
+  const char *tok, *colon;
+  sp_column_header_t *h;
+  uint32_t len, name_len;
+  char *end;
+  long width;
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++)
+    sph->col[c].visible = 0;
+  sph->order_count = 0;
+  sph->given = 1;
+
+  while ((tok = sp_token_next(&cursor, ',', &len)) != NULL) {
+    colon = memchr(tok, ':', len);
+    name_len = (colon != NULL) ? (uint32_t)(colon - tok) : len;
+    for (c = 0; c < SPART_COLUMN_COUNT; c++)
+      if ((sp_columns[c].kind != SPART_COLUMN_LABEL) &&
+          (strlen(sp_columns[c].name) == name_len) &&
+          (strncmp(sp_columns[c].name, tok, name_len) == 0))
+        break;
+    if (c == SPART_COLUMN_COUNT) {
+      printf("\nUnknown column: %.*s\n", (int)name_len, tok);
+      return 0;
     }
-    if (sph->djt_time.visible) {
-      sp_date_print(sp->djt_time, sph->djt_time.column_width, show_as_date);
+    if (sph->order_count == SPART_MAX_COLUMNS) {
+      printf("\nToo many columns: %s\n", format);
+      return 0;
     }
-    if (sph->mjt_time.visible) {
-      sp_date_print(sp->mjt_time, sph->mjt_time.column_width, show_as_date);
+    h = &(sph->col[c]);
+    if (colon != NULL) {
+      width = strtol(colon + 1, &end, 10);
+      if ((end != tok + len) || (width < 1) ||
+          (width >= SPART_MAX_COLUMN_SIZE)) {
+        printf("\nThe column width should be 1-%d: %.*s\n",
+               SPART_MAX_COLUMN_SIZE - 1, (int)len, tok);
+        return 0;
+      }
+      h->column_width = width;
     }
-    if (sph->min_core.visible) {
-      if ((show_max_mem == 1) && (sp->min_core != sp->max_core))
-        snprintf(mem_result, SPART_INFO_STRING_SIZE, "%d-%d", sp->min_core,
-                 sp->max_core);
-      else
-        snprintf(mem_result, SPART_INFO_STRING_SIZE, "%*d",
-                 sph->min_core.column_width, sp->min_core);
-      printf("%*s ", sph->min_core.column_width, mem_result);
+    h->visible = 1;
+    sph->order[sph->order_count++] = c;
+  }
+  if (sph->order_count == 0) {
+    printf("\nNo column is given: %s\n", format);
+    return 0;
+  }
+  return 1;
+}
+
+/* Adds visible Headers to the output */
+void sp_headers_print(sp_strbuf_t *out, sp_headers_t *sph) {
+  const sp_column_t *col;
+  sp_strbuf_t line1;
+  sp_strbuf_t line2;
+  size_t c;
+
+  sp_strbuf_init(&line1);
+  sp_strbuf_init(&line2);
+
+  for (c = 0; c < sph->order_count; c++) {
+    col = &sp_columns[sph->order[c]];
+    if ((col->before != NULL) && !(sph->col[SPART_COL_LABEL].visible) &&
+        !(sph->given)) {
+      sp_strbuf_cat(&line1, col->before);
+      sp_strbuf_cat(&line2, col->before);
     }
-    if (sph->min_mem_gb.visible) {
-      if ((show_max_mem == 1) && (sp->min_mem_gb != sp->max_mem_gb))
-        snprintf(mem_result, SPART_INFO_STRING_SIZE, "%d-%d", sp->min_mem_gb,
-                 sp->max_mem_gb);
-      else
-        snprintf(mem_result, SPART_INFO_STRING_SIZE, "%*d",
-                 sph->min_mem_gb.column_width, sp->min_mem_gb);
-      printf("%*s ", sph->min_mem_gb.column_width, mem_result);
+    sp_column_header_print(&line1, &line2, &(sph->col[sph->order[c]]));
+  }
+  sp_strbuf_catn(out, line1.data, line1.len);
+  sp_strbuf_catn(out, "\n", 1);
+  sp_strbuf_catn(out, line2.data, line2.len);
+  sp_strbuf_catn(out, "\n", 1);
+  sp_strbuf_free(&line1);
+  sp_strbuf_free(&line2);
+}
+
+/* Finds the visible columns, which have the same value at all visible
+ * partitions, with one pass over the partitions. A group is common, if all
+ * of its visible columns are common. The common columns are hidden, and
+ * their common flags are set. Sets the first visible partition, and returns
+ * 1 if there is a common column. */
+int sp_columns_common(sp_headers_t *sph, const sp_part_info_t *spData,
+                      uint32_t partition_count, const sp_strpool_t *strs,
+                      int flags, uint32_t *first) {
+  size_t candidates[SPART_COLUMN_COUNT];
+  sp_column_header_t *h;
+  uint32_t i, broken = 0;
+  size_t c, n = 0, m;
+  int found = 0;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++) {
+    h = &(sph->col[c]);
+    h->common = 0;
+    if ((sp_columns[c].kind == SPART_COLUMN_COMMON) && (h->visible))
+      candidates[n++] = c;
+  }
+  for (i = 0; (i < partition_count) && !(spData[i].visible); i++)
+    ;
+  if (i == partition_count) return 0;
+  *first = i;
+
+  /* the columns which differ from the first partition are dropped */
+  for (i++; (i < partition_count) && (n > 0); i++) {
+    if (!(spData[i].visible)) continue;
+    for (c = 0, m = 0; c < n; c++)
+      if (sp_columns[candidates[c]].compare(&sp_columns[candidates[c]],
+                                            &spData[*first], &spData[i], strs,
+                                            flags) == 0)
+        candidates[m++] = candidates[c];
+    n = m;
+  }
+  for (c = 0; c < n; c++) sph->col[candidates[c]].common = 1;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++) {
+    h = &(sph->col[c]);
+    if ((sp_columns[c].kind == SPART_COLUMN_COMMON) && (h->visible) &&
+        !(h->common))
+      broken |= 1u << sp_columns[c].group;
+  }
+  for (c = 0; c < SPART_COLUMN_COUNT; c++) {
+    h = &(sph->col[c]);
+    if (!(h->common)) continue;
+    if ((sp_columns[c].group != SPART_GROUP_NONE) &&
+        (broken & (1u << sp_columns[c].group))) {
+      h->common = 0;
+      continue;
     }
-    if (sph->partition_qos.visible)
-      printf("%*s ", sph->partition_qos.column_width, sp->partition_qos);
+    h->visible = 0;
+    found = 1;
+  }
+  return found;
+}
+
+/* Makes only the common columns visible, to print the COMMON VALUES */
+void sp_columns_show_common(sp_headers_t *sph) {
+  sp_column_header_t *h;
+  size_t c;
+
+  for (c = 0; c < SPART_COLUMN_COUNT; c++) {
+    h = &(sph->col[c]);
+    h->visible = (sp_columns[c].kind == SPART_COLUMN_LABEL) || (h->common);
+  }
+}
+
+/* Returns the output width of the partition lines */
+int sp_columns_width(sp_headers_t *sph) {
+  const sp_column_t *col;
+  sp_column_header_t *h;
+  int total_width = 7; /* for || and space charecters */
+  size_t c;
+
+  for (c = 0; c < sph->order_count; c++) {
+    col = &sp_columns[sph->order[c]];
+    h = &(sph->col[sph->order[c]]);
+    if (col->kind == SPART_COLUMN_FIXED)
+      total_width += h->column_width;
+    else if ((col->kind == SPART_COLUMN_COMMON) && (h->visible))
+      total_width += h->column_width + 1;
+  }
+  return total_width;
+}
 
-    if (sph->gres.visible) printf("%-*s ", sph->gres.column_width, sp->gres);
-    if (sph->features.visible)
-      printf("%-*s ", sph->features.column_width, sp->features);
-    printf("\n");
+/* Adds a partition info to the output */
+void sp_partition_print(sp_strbuf_t *out, sp_part_info_t *sp,
+                        const sp_strpool_t *strs, sp_headers_t *sph,
+                        int show_max_mem, int show_as_date, int total_width) {
 #ifdef SPART_SHOW_STATEMENT
-    if (sp->show_statement && !(sph->hspace.visible)) {
+  char mem_result[SPART_INFO_STRING_SIZE];
+#endif
+  const sp_column_t *col;
+  sp_column_header_t *h;
+  int flags = 0;
+  size_t c;
+
+  if (sp->visible) {
+    if (show_max_mem == 1) flags |= SPART_PRINT_MAX_MEM;
+    if (show_as_date) flags |= SPART_PRINT_AS_DATE;
+    for (c = 0; c < sph->order_count; c++) {
+      col = &sp_columns[sph->order[c]];
+      if ((col->before != NULL) && !(sph->col[SPART_COL_LABEL].visible) &&
+          !(sph->given))
+        sp_strbuf_cat(out, col->before);
+      h = &(sph->col[sph->order[c]]);
+      if (h->visible) col->print(out, col, sp, strs, h->column_width, flags);
+    }
+    sp_strbuf_catn(out, "\n", 1);
+#ifdef SPART_SHOW_STATEMENT
+    if (sp->show_statement && !(sph->col[SPART_COL_LABEL].visible)) {
       snprintf(mem_result, SPART_INFO_STRING_SIZE, "%s%s%s%s",
-               SPART_STATEMENT_DIR, SPART_STATEMENT_QUEPRE, sp->partition_name,
-               SPART_STATEMENT_QUEPOST);
-      sp_statement_print(mem_result, sp->partition_name, total_width);
+               SPART_STATEMENT_DIR, SPART_STATEMENT_QUEPRE,
+               sp_str(strs, sp->partition_name), SPART_STATEMENT_QUEPOST);
+      sp_statement_print(out, mem_result, sp_str(strs, sp->partition_name),
+                         total_width);
     }
 #endif
   }
 }
 
-/* print user info  ( -i parameter output ) */
-void sp_print_user_info(char *user_name, char **user_group,
+/* Adds the visible columns of a partition to the JSON object */
+void sp_partition_json_columns(sp_json_t *js, const sp_part_info_t *sp,
+                               const sp_strpool_t *strs, sp_headers_t *sph) {
+  const sp_column_t *col;
+  size_t c;
+
+  for (c = 0; c < sph->order_count; c++) {
+    col = &sp_columns[sph->order[c]];
+    if ((col->json == NULL) || !(sph->col[sph->order[c]].visible))
+      continue;
+    sp_json_key(js, sp_column_key(col));
+    col->json(js, col, sp, strs);
+  }
+}
+
+/* Writes a partition as a JSON line */
+void sp_partition_json(sp_json_t *js, const sp_part_info_t *sp,
+                       const sp_strpool_t *strs, sp_headers_t *sph) {
+  if (!(sp->visible)) return;
+  sp_json_begin(js);
+  sp_partition_json_columns(js, sp, strs, sph);
+  sp_json_end(js, 1);
+}
+
+/* Adds the user info to the output ( -i parameter output ) */
+void sp_print_user_info(sp_strbuf_t *out, char *user_name, char **user_group,
                         int user_group_count, char **user_acct,
                         int user_acct_count, char **user_qos,
                         int user_qos_count) {
   int k;
-  printf(" Your username: %s\n", user_name);
-  printf(" Your group(s): ");
+  sp_strbuf_printf(out, " Your username: %s\n", user_name);
+  sp_strbuf_cat(out, " Your group(s): ");
   for (k = 0; k < user_group_count; k++) {
-    printf("%s ", user_group[k]);
+    sp_strbuf_cat(out, user_group[k]);
+    sp_strbuf_catn(out, " ", 1);
   }
-  printf("\n");
-  printf(" Your account(s): ");
+  sp_strbuf_catn(out, "\n", 1);
+  sp_strbuf_cat(out, " Your account(s): ");
   for (k = 0; k < user_acct_count; k++) {
-    printf("%s ", user_acct[k]);
+    sp_strbuf_cat(out, user_acct[k]);
+    sp_strbuf_catn(out, " ", 1);
   }
-  printf("\n Your qos(s): ");
+  sp_strbuf_cat(out, "\n Your qos(s): ");
   for (k = 0; k < user_qos_count; k++) {
-    printf("%s ", user_qos[k]);
+    sp_strbuf_cat(out, user_qos[k]);
+    sp_strbuf_catn(out, " ", 1);
   }
-  printf("\n");
+  sp_strbuf_catn(out, "\n", 1);
 }
 
 #endif /* SPART_SPART_OUTPUT_H_incl */
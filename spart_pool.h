@@ -0,0 +1,81 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_POOL_H_incl
+#define SPART_SPART_POOL_H_incl
+
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The strings of a run are stored one after the other in a growing buffer,
+ * and referenced by their offsets. The offset 0 is the empty string, so a
+ * zeroed record has empty strings. */
+typedef struct sp_strpool {
+  char *data;
+  uint32_t used;
+  uint32_t size;
+} sp_strpool_t;
+
+void sp_strpool_init(sp_strpool_t *sp) {
+  sp->size = 4096;
+  sp->data = malloc(sp->size);
+  if (sp->data == NULL) {
+    slurm_perror("Can not allocate string pool");
+    exit(1);
+  }
+  sp->data[0] = 0;
+  sp->used = 1;
+}
+
+void sp_strpool_free(sp_strpool_t *sp) {
+  free(sp->data);
+  sp->data = NULL;
+  sp->used = 0;
+  sp->size = 0;
+}
+
+/* Returns the string at the offset */
+const char *sp_str(const sp_strpool_t *sp, uint32_t offset) {
+  return sp->data + offset;
+}
+
+/* Appends chars to the string which is being built. It is ended by
+ * sp_strpool_end. */
+void sp_strpool_cat(sp_strpool_t *sp, const char *str, uint32_t len) {
+  while (sp->used + len + 1 > sp->size) {
+    sp->size *= 2;
+    sp->data = realloc(sp->data, sp->size);
+    if (sp->data == NULL) {
+      slurm_perror("Can not allocate string pool");
+      exit(1);
+    }
+  }
+  memcpy(sp->data + sp->used, str, len);
+  sp->used += len;
+}
+
+/* Ends the string which is started at the start offset, and returns its
+ * offset. An empty string is not stored. */
+uint32_t sp_strpool_end(sp_strpool_t *sp, uint32_t start) {
+  if (sp->used == start) return 0;
+  sp_strpool_cat(sp, "", 0);
+  sp->data[sp->used++] = 0;
+  return start;
+}
+
+/* Adds a string, and returns its offset. NULL is stored as empty. */
+uint32_t sp_strpool_add(sp_strpool_t *sp, const char *str) {
+  uint32_t start = sp->used;
+  if (str == NULL) return 0;
+  sp_strpool_cat(sp, str, strlen(str));
+  return sp_strpool_end(sp, start);
+}
+
+#endif /* SPART_SPART_POOL_H_incl */
@@ -0,0 +1,423 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_RECORD_H_incl
+#define SPART_SPART_RECORD_H_incl
+
+#include <errno.h>
+#include <fcntl.h>
+#include <slurm/slurm.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "spart.h"
+#include "spart_arena.h"
+#include "spart_data.h"
+#include "spart_fetch.h"
+#include "spart_string.h"
+#include "spart_user.h"
+
+/* A record file keeps the slurm data and the user info, which are read by
+ * the spart, so a run can be repeated without the slurm. It is written in
+ * the byte order of the host, and only the fields which the spart uses
+ * are kept:
+ *
+ *   "SPARTREC" version show_partition
+ *   conf:  private_data cluster_name
+ *   user:  name uid gid groups accounts qoss
+ *   nodes: count, {cpus real_memory alloc_cpus node_state reason gres
+ *                  features features_act}
+ *   parts: count, {name cluster_name allow_accounts allow_groups allow_qos
+ *                  deny_accounts deny_qos qos_char flags state_up
+ *                  default_time max_time max_cpus_per_node max_nodes
+ *                  min_nodes total_cpus total_nodes def_mem_per_cpu
+ *                  max_mem_per_cpu node_inx}
+ *   jobs:  count, {job_state num_cpus state_reason user_id partition}
+ *
+ * The numbers are uint32_t, except the memory values, which are uint64_t.
+ * A string is its length, its chars, and a zero. The length of a NULL
+ * string is SPART_RECORD_NULL. */
+#define SPART_RECORD_MAGIC "SPARTREC"
+#define SPART_RECORD_VERSION 1
+#define SPART_RECORD_NULL 0xffffffffu
+
+/* The slurm messages of a record file. They are made like the slurm api
+ * makes them, so the same code reads them. */
+typedef struct sp_record {
+#if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
+  slurm_conf_t conf;
+#else
+  slurm_ctl_conf_t conf;
+#endif
+  node_info_msg_t nodes;
+  partition_info_msg_t parts;
+  job_info_msg_t jobs;
+  uint16_t show_partition;
+  /* the allocated cores of the nodes, which are read from the select
+   * plugin while recording */
+  uint16_t *alloc_cpus;
+  /* the file, which the strings point into, and the arrays */
+  char *data;
+  sp_arena_t arena;
+} sp_record_t;
+
+/* The read position in a record file. After an error, all values are 0. */
+typedef struct sp_record_reader {
+  char *pos;
+  char *end;
+  int error;
+} sp_record_reader_t;
+
+void sp_record_put_u32(sp_strbuf_t *out, uint32_t num) {
+  sp_strbuf_catn(out, (const char *)&num, sizeof(num));
+}
+
+void sp_record_put_u64(sp_strbuf_t *out, uint64_t num) {
+  sp_strbuf_catn(out, (const char *)&num, sizeof(num));
+}
+
+void sp_record_put_str(sp_strbuf_t *out, const char *str) {
+  uint32_t len;
+
+  if (str == NULL) {
+    sp_record_put_u32(out, SPART_RECORD_NULL);
+    return;
+  }
+  len = strlen(str);
+  sp_record_put_u32(out, len);
+  sp_strbuf_catn(out, str, len + 1);
+}
+
+/* Writes a list of the user info */
+void sp_record_put_list(sp_strbuf_t *out, char **list, int count) {
+  int k;
+
+  sp_record_put_u32(out, count);
+  for (k = 0; k < count; k++) sp_record_put_str(out, list[k]);
+}
+
+uint32_t sp_record_get_u32(sp_record_reader_t *r) {
+  uint32_t num = 0;
+
+  if ((r->error) || ((size_t)(r->end - r->pos) < sizeof(num))) {
+    r->error = 1;
+    return 0;
+  }
+  memcpy(&num, r->pos, sizeof(num));
+  r->pos += sizeof(num);
+  return num;
+}
+
+uint64_t sp_record_get_u64(sp_record_reader_t *r) {
+  uint64_t num = 0;
+
+  if ((r->error) || ((size_t)(r->end - r->pos) < sizeof(num))) {
+    r->error = 1;
+    return 0;
+  }
+  memcpy(&num, r->pos, sizeof(num));
+  r->pos += sizeof(num);
+  return num;
+}
+
+/* Returns a string in the file, without a copy */
+char *sp_record_get_str(sp_record_reader_t *r) {
+  uint32_t len = sp_record_get_u32(r);
+  char *str;
+
+  if ((r->error) || (len == SPART_RECORD_NULL)) return NULL;
+  if (((size_t)(r->end - r->pos) <= len) || (r->pos[len] != '\0')) {
+    r->error = 1;
+    return NULL;
+  }
+  str = r->pos;
+  r->pos += len + 1;
+  return str;
+}
+
+/* Returns the count of the next records. Each record has at least one
+ * byte, so a broken count is found before the allocation. */
+uint32_t sp_record_get_count(sp_record_reader_t *r) {
+  uint32_t count = sp_record_get_u32(r);
+
+  if ((size_t)(r->end - r->pos) < count) r->error = 1;
+  return (r->error) ? 0 : count;
+}
+
+/* Reads a list of the user info */
+void sp_record_get_list(sp_record_reader_t *r, sp_arena_t *arena,
+                        char ***list, int *count) {
+  uint32_t k, n = sp_record_get_count(r);
+  char *str;
+
+  *list = NULL;
+  *count = 0;
+  for (k = 0; k < n; k++) {
+    str = sp_record_get_str(r);
+    if (str != NULL) sp_user_list_add(arena, list, count, str);
+  }
+}
+
+/* Writes the loaded slurm data, and the user info to a record file. All
+ * requests and the user info should be loaded. Returns 0 on error. */
+int sp_record_write(const char *path, sp_fetch_t *spf) {
+  sp_user_info_t *user = spf->user;
+  partition_info_t *part_ptr;
+  node_info_t *node_ptr;
+  slurm_job_info_t *job_ptr;
+  sp_strbuf_t out;
+  uint32_t i, j, n;
+  int rc;
+
+  sp_strbuf_init(&out);
+  sp_strbuf_catn(&out, SPART_RECORD_MAGIC, strlen(SPART_RECORD_MAGIC));
+  sp_record_put_u32(&out, SPART_RECORD_VERSION);
+  sp_record_put_u32(&out, spf->show_partition);
+
+  sp_record_put_u32(&out, spf->conf_info_msg_ptr->private_data);
+#ifdef __slurmdb_cluster_rec_t_defined
+  sp_record_put_str(&out, spf->conf_info_msg_ptr->cluster_name);
+#else
+  sp_record_put_str(&out, NULL);
+#endif
+
+  sp_record_put_str(&out, user->user_name);
+  sp_record_put_u32(&out, user->user_id);
+  sp_record_put_u32(&out, user->group_id);
+  sp_record_put_list(&out, user->user_group, user->user_group_count);
+  sp_record_put_list(&out, user->user_acct, user->user_acct_count);
+  sp_record_put_list(&out, user->user_qos, user->user_qos_count);
+
+  sp_record_put_u32(&out, spf->node_buffer_ptr->record_count);
+  for (i = 0; i < spf->node_buffer_ptr->record_count; i++) {
+    node_ptr = &(spf->node_buffer_ptr->node_array[i]);
+    sp_record_put_u32(&out, node_ptr->cpus);
+    sp_record_put_u64(&out, node_ptr->real_memory);
+    sp_record_put_u32(&out, sp_node_alloc_cpus(node_ptr));
+    sp_record_put_u32(&out, node_ptr->node_state);
+    sp_record_put_str(&out, node_ptr->reason);
+    sp_record_put_str(&out, node_ptr->gres);
+    sp_record_put_str(&out, node_ptr->features);
+    sp_record_put_str(&out, node_ptr->features_act);
+  }
+
+  sp_record_put_u32(&out, spf->part_buffer_ptr->record_count);
+  for (i = 0; i < spf->part_buffer_ptr->record_count; i++) {
+    part_ptr = &(spf->part_buffer_ptr->partition_array[i]);
+    sp_record_put_str(&out, part_ptr->name);
+#ifdef __slurmdb_cluster_rec_t_defined
+    sp_record_put_str(&out, part_ptr->cluster_name);
+#else
+    sp_record_put_str(&out, NULL);
+#endif
+    sp_record_put_str(&out, part_ptr->allow_accounts);
+    sp_record_put_str(&out, part_ptr->allow_groups);
+    sp_record_put_str(&out, part_ptr->allow_qos);
+    sp_record_put_str(&out, part_ptr->deny_accounts);
+    sp_record_put_str(&out, part_ptr->deny_qos);
+    sp_record_put_str(&out, part_ptr->qos_char);
+    sp_record_put_u32(&out, part_ptr->flags);
+    sp_record_put_u32(&out, part_ptr->state_up);
+    sp_record_put_u32(&out, part_ptr->default_time);
+    sp_record_put_u32(&out, part_ptr->max_time);
+    sp_record_put_u32(&out, part_ptr->max_cpus_per_node);
+    sp_record_put_u32(&out, part_ptr->max_nodes);
+    sp_record_put_u32(&out, part_ptr->min_nodes);
+    sp_record_put_u32(&out, part_ptr->total_cpus);
+    sp_record_put_u32(&out, part_ptr->total_nodes);
+    sp_record_put_u64(&out, part_ptr->def_mem_per_cpu);
+    sp_record_put_u64(&out, part_ptr->max_mem_per_cpu);
+    /* the node index pairs, with the ending -1 */
+    n = 0;
+    if (part_ptr->node_inx != NULL)
+      while (part_ptr->node_inx[n] != -1) n += 2;
+    sp_record_put_u32(&out, (part_ptr->node_inx != NULL) ? n + 1 : 0);
+    for (j = 0; (part_ptr->node_inx != NULL) && (j <= n); j++)
+      sp_record_put_u32(&out, (uint32_t)(part_ptr->node_inx[j]));
+  }
+
+  sp_record_put_u32(&out, spf->job_buffer_ptr->record_count);
+  for (i = 0; i < spf->job_buffer_ptr->record_count; i++) {
+    job_ptr = &(spf->job_buffer_ptr->job_array[i]);
+    sp_record_put_u32(&out, job_ptr->job_state);
+    sp_record_put_u32(&out, job_ptr->num_cpus);
+    sp_record_put_u32(&out, job_ptr->state_reason);
+    sp_record_put_u32(&out, job_ptr->user_id);
+    sp_record_put_str(&out, job_ptr->partition);
+  }
+
+  rc = sp_strbuf_save(&out, path);
+  sp_strbuf_free(&out);
+  return rc;
+}
+
+/* Reads a record file, and the user info in it. Returns 1 on success. */
+int sp_record_read(sp_record_t *rec, const char *path, sp_user_info_t *user) {
+  sp_record_reader_t r;
+  partition_info_t *part_ptr;
+  node_info_t *node_ptr;
+  slurm_job_info_t *job_ptr;
+  struct stat st;
+  char *str;
+  size_t done = 0;
+  ssize_t len;
+  uint32_t i, j, n;
+  int fd;
+
+  memset(rec, 0, sizeof(sp_record_t));
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return 0;
+  if ((fstat(fd, &st) != 0) ||
+      (st.st_size < (off_t)strlen(SPART_RECORD_MAGIC) + 8)) {
+    close(fd);
+    return 0;
+  }
+  rec->data = malloc(st.st_size);
+  if (rec->data == NULL) {
+    close(fd);
+    return 0;
+  }
+  while (done < (size_t)st.st_size) {
+    len = read(fd, rec->data + done, st.st_size - done);
+    if ((len < 0) && (errno == EINTR)) continue;
+    if (len <= 0) break;
+    done += len;
+  }
+  close(fd);
+
+  r.pos = rec->data + strlen(SPART_RECORD_MAGIC);
+  r.end = rec->data + done;
+  r.error = (done != (size_t)st.st_size) ||
+            (memcmp(rec->data, SPART_RECORD_MAGIC,
+                    strlen(SPART_RECORD_MAGIC)) != 0);
+  if (sp_record_get_u32(&r) != SPART_RECORD_VERSION) r.error = 1;
+  rec->show_partition = sp_record_get_u32(&r);
+
+  rec->conf.private_data = sp_record_get_u32(&r);
+#ifdef __slurmdb_cluster_rec_t_defined
+  rec->conf.cluster_name = sp_record_get_str(&r);
+#else
+  sp_record_get_str(&r);
+#endif
+
+  /* the user of the record is used, instead of the calling user */
+  sp_user_free(user);
+  str = sp_record_get_str(&r);
+  if ((str == NULL) || (strlen(str) >= SPART_INFO_STRING_SIZE))
+    r.error = 1;
+  else
+    sp_strn2cpy(user->user_name, SPART_INFO_STRING_SIZE, str,
+                SPART_INFO_STRING_SIZE);
+  user->user_id = sp_record_get_u32(&r);
+  user->group_id = sp_record_get_u32(&r);
+  sp_record_get_list(&r, &(rec->arena), &(user->user_group),
+                     &(user->user_group_count));
+  sp_record_get_list(&r, &(rec->arena), &(user->user_acct),
+                     &(user->user_acct_count));
+  sp_record_get_list(&r, &(rec->arena), &(user->user_qos),
+                     &(user->user_qos_count));
+
+  rec->nodes.record_count = sp_record_get_count(&r);
+  rec->nodes.node_array = sp_arena_alloc(
+      &(rec->arena), (rec->nodes.record_count + 1) * sizeof(node_info_t));
+  rec->alloc_cpus = sp_arena_alloc(
+      &(rec->arena), (rec->nodes.record_count + 1) * sizeof(uint16_t));
+  memset(rec->nodes.node_array, 0,
+         rec->nodes.record_count * sizeof(node_info_t));
+  for (i = 0; i < rec->nodes.record_count; i++) {
+    node_ptr = &(rec->nodes.node_array[i]);
+    node_ptr->cpus = sp_record_get_u32(&r);
+    node_ptr->real_memory = sp_record_get_u64(&r);
+    rec->alloc_cpus[i] = sp_record_get_u32(&r);
+    node_ptr->node_state = sp_record_get_u32(&r);
+    node_ptr->reason = sp_record_get_str(&r);
+    node_ptr->gres = sp_record_get_str(&r);
+    node_ptr->features = sp_record_get_str(&r);
+    node_ptr->features_act = sp_record_get_str(&r);
+  }
+
+  rec->parts.record_count = sp_record_get_count(&r);
+  rec->parts.partition_array =
+      sp_arena_alloc(&(rec->arena),
+                     (rec->parts.record_count + 1) * sizeof(partition_info_t));
+  memset(rec->parts.partition_array, 0,
+         rec->parts.record_count * sizeof(partition_info_t));
+  for (i = 0; i < rec->parts.record_count; i++) {
+    part_ptr = &(rec->parts.partition_array[i]);
+    part_ptr->name = sp_record_get_str(&r);
+#ifdef __slurmdb_cluster_rec_t_defined
+    part_ptr->cluster_name = sp_record_get_str(&r);
+#else
+    sp_record_get_str(&r);
+#endif
+    part_ptr->allow_accounts = sp_record_get_str(&r);
+    part_ptr->allow_groups = sp_record_get_str(&r);
+    part_ptr->allow_qos = sp_record_get_str(&r);
+    part_ptr->deny_accounts = sp_record_get_str(&r);
+    part_ptr->deny_qos = sp_record_get_str(&r);
+    part_ptr->qos_char = sp_record_get_str(&r);
+    part_ptr->flags = sp_record_get_u32(&r);
+    part_ptr->state_up = sp_record_get_u32(&r);
+    part_ptr->default_time = sp_record_get_u32(&r);
+    part_ptr->max_time = sp_record_get_u32(&r);
+    part_ptr->max_cpus_per_node = sp_record_get_u32(&r);
+    part_ptr->max_nodes = sp_record_get_u32(&r);
+    part_ptr->min_nodes = sp_record_get_u32(&r);
+    part_ptr->total_cpus = sp_record_get_u32(&r);
+    part_ptr->total_nodes = sp_record_get_u32(&r);
+    part_ptr->def_mem_per_cpu = sp_record_get_u64(&r);
+    part_ptr->max_mem_per_cpu = sp_record_get_u64(&r);
+    n = sp_record_get_count(&r);
+    if (n == 0) continue;
+    part_ptr->node_inx = sp_arena_alloc(&(rec->arena), n * sizeof(int32_t));
+    for (j = 0; j < n; j++)
+      part_ptr->node_inx[j] = (int32_t)sp_record_get_u32(&r);
+    /* the pairs should be in the nodes, and the last one should be -1 */
+    if ((n % 2 == 0) || (part_ptr->node_inx[n - 1] != -1)) r.error = 1;
+    for (j = 0; (j + 1 < n) && (!r.error); j += 2)
+      if ((part_ptr->node_inx[j] < 0) ||
+          (part_ptr->node_inx[j] > part_ptr->node_inx[j + 1]) ||
+          ((uint32_t)(part_ptr->node_inx[j + 1]) >= rec->nodes.record_count))
+        r.error = 1;
+    if (r.error) part_ptr->node_inx = NULL;
+  }
+
+  rec->jobs.record_count = sp_record_get_count(&r);
+  rec->jobs.job_array =
+      sp_arena_alloc(&(rec->arena),
+                     (rec->jobs.record_count + 1) * sizeof(slurm_job_info_t));
+  memset(rec->jobs.job_array, 0,
+         rec->jobs.record_count * sizeof(slurm_job_info_t));
+  for (i = 0; i < rec->jobs.record_count; i++) {
+    job_ptr = &(rec->jobs.job_array[i]);
+    job_ptr->job_state = sp_record_get_u32(&r);
+    job_ptr->num_cpus = sp_record_get_u32(&r);
+    job_ptr->state_reason = sp_record_get_u32(&r);
+    job_ptr->user_id = sp_record_get_u32(&r);
+    job_ptr->partition = sp_record_get_str(&r);
+    if (job_ptr->partition == NULL) job_ptr->partition = "";
+  }
+
+  if ((r.error) || (r.pos != r.end)) {
+    free(rec->data);
+    sp_arena_free(&(rec->arena));
+    memset(rec, 0, sizeof(sp_record_t));
+    sp_user_free(user);
+    return 0;
+  }
+  return 1;
+}
+
+void sp_record_free(sp_record_t *rec) {
+  free(rec->data);
+  sp_arena_free(&(rec->arena));
+  memset(rec, 0, sizeof(sp_record_t));
+}
+
+#endif /* SPART_SPART_RECORD_H_incl */
@@ -0,0 +1,459 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_SERVER_H_incl
+#define SPART_SPART_SERVER_H_incl
+
+#ifdef SPART_SERVER_SOCKET
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "spart.h"
+#include "spart_cache.h"
+#include "spart_data.h"
+#include "spart_fetch.h"
+#include "spart_string.h"
+
+/* The server keeps the data for a few different show_partition values */
+#define SPART_SERVER_VIEW_COUNT 4
+/* The server answers this many clients at the same time */
+#define SPART_SERVER_CLIENT_COUNT 64
+/* A client, which does not send its query or read its answer in this
+ * many seconds, is dropped */
+#define SPART_SERVER_CLIENT_TIMEOUT 1.0
+
+/* The views are refreshed by a thread, while the main thread answers the
+ * clients. The answers of the views are changed under the lock. */
+typedef struct sp_server {
+  sp_server_view_t views[SPART_SERVER_VIEW_COUNT];
+  int view_count;
+  const char *snapshot_file;
+  pthread_mutex_t lock;
+} sp_server_t;
+
+/* A connected client, whose query is read and answer is sent without
+ * blocking the server */
+typedef struct sp_server_client {
+  int fd;
+  uint32_t user_id;
+  double deadline;
+  sp_server_query_t q;
+  size_t received;
+  char *answer;
+  size_t answer_size;
+  size_t sent;
+} sp_server_client_t;
+
+/* Serializes the partitions of a view, to send them to the clients.
+ * Returns NULL on error. */
+char *sp_server_serialize(size_t *size, uint16_t private_data,
+                          const char *cluster_name, sp_part_info_t *spData,
+                          uint32_t partition_count,
+                          const sp_strpool_t *strs) {
+  sp_snap_writer_t w;
+  char *parts = NULL;
+
+  *size = 0;
+  w.fo = open_memstream(&parts, size);
+  if (w.fo == NULL) return NULL;
+  w.offset = 0;
+  sp_snap_write_parts(&w, time(NULL), private_data, cluster_name, spData,
+                      partition_count, strs);
+  fclose(w.fo);
+  return parts;
+}
+
+/* Replaces the answer of a view. The parts and the items are owned by the
+ * view after the call, and the old ones are freed. */
+void sp_server_publish(sp_server_t *s, sp_server_view_t *v,
+                       uint16_t private_data, char *parts, size_t parts_size,
+                       sp_user_jobs_list_t *ujl) {
+  sp_user_jobs_list_t old_jobs;
+  char *old_parts;
+
+  pthread_mutex_lock(&(s->lock));
+  old_parts = v->parts;
+  old_jobs = v->user_jobs;
+  v->private_data = private_data;
+  v->parts = parts;
+  v->parts_size = (parts != NULL) ? parts_size : 0;
+  v->user_jobs = *ujl;
+  pthread_mutex_unlock(&(s->lock));
+
+  free(old_parts);
+  free(old_jobs.items);
+}
+
+/* Loads the changed slurm data, and computes the partition values again.
+ * If a request fails, the clients ask the slurmctld until the next
+ * refresh. Only the refresh thread uses the spf of the view. */
+void sp_server_refresh(sp_server_t *s, sp_server_view_t *v) {
+  char cluster_name[SPART_MAX_COLUMN_SIZE];
+  sp_user_jobs_list_t ujl = {0, 0, NULL};
+  sp_node_info_t *spNodes = NULL;
+  sp_part_info_t *spData = NULL;
+  sp_part_index_t part_index;
+  sp_strpool_t strs;
+  sp_arena_t arena;
+  uint16_t private_data;
+  char *parts;
+  size_t parts_size;
+  int k, changed = 0;
+
+  v->spf.show_partition = v->show_partition;
+  v->spf.wanted = SPART_FETCH_SLURM;
+  sp_fetch_all(&(v->spf));
+  for (k = 0; k < SPART_FETCH_COUNT; k++) {
+    if (v->spf.request[k].error) {
+      fprintf(stderr, "%s: %s\n", sp_fetch_error_info[k],
+              slurm_strerror(v->spf.request[k].error));
+      sp_server_publish(s, v, 0, NULL, 0, &ujl);
+      return;
+    }
+    if (v->spf.request[k].changed) changed = 1;
+  }
+  /* the parts of the view are changed only by this thread */
+  if ((!changed) && (v->parts != NULL)) return;
+
+  private_data = v->spf.conf_info_msg_ptr->private_data;
+  cluster_name[0] = 0;
+#ifdef __slurmdb_cluster_rec_t_defined
+  sp_strn2cpy(cluster_name, SPART_MAX_COLUMN_SIZE,
+              v->spf.conf_info_msg_ptr->cluster_name, SPART_MAX_COLUMN_SIZE);
+#endif
+
+  memset(&arena, 0, sizeof(sp_arena_t));
+  sp_strpool_init(&strs);
+  spNodes = sp_nodes_read(&arena, v->spf.node_buffer_ptr,
+                          v->spf.part_buffer_ptr, NULL, NULL);
+  spData = sp_parts_read(&arena, v->spf.part_buffer_ptr,
+                         v->spf.node_buffer_ptr, spNodes, cluster_name,
+                         SPART_PLAN_ALL, NULL, &strs);
+
+  /* the my_xxx values of the spData are not used */
+  sp_part_index_build(&part_index, v->spf.part_buffer_ptr, NULL);
+  sp_jobs_count(spData, &part_index, v->spf.job_buffer_ptr, -1, &ujl);
+  sp_part_index_free(&part_index);
+
+  parts = sp_server_serialize(&parts_size, private_data, cluster_name, spData,
+                              v->spf.part_buffer_ptr->record_count, &strs);
+  sp_server_publish(s, v, private_data, parts, parts_size, &ujl);
+  sp_strpool_free(&strs);
+  sp_arena_free(&arena);
+}
+
+/* Loads the data from a snapshot file instead of the slurmctld. It is used
+ * to test the server and the clients without a slurm cluster. */
+void sp_server_load(sp_server_t *s, sp_server_view_t *v,
+                    const char *snapshot_file) {
+  sp_user_jobs_list_t ujl = {0, 0, NULL};
+  sp_snapshot_t snap;
+  char *parts;
+  size_t parts_size;
+
+  if (!sp_snap_map(snapshot_file, &snap)) {
+    fprintf(stderr, "Can not read the snapshot file: %s\n", snapshot_file);
+    sp_server_publish(s, v, 0, NULL, 0, &ujl);
+    return;
+  }
+  if (snap.user_jobs_count) {
+    ujl.size = snap.user_jobs_count;
+    ujl.count = snap.user_jobs_count;
+    ujl.items = malloc(ujl.size * sizeof(sp_user_jobs_t));
+    if (ujl.items == NULL) {
+      slurm_perror("Can not allocate user job list");
+      exit(1);
+    }
+    memcpy(ujl.items, snap.user_jobs,
+           snap.user_jobs_count * sizeof(sp_user_jobs_t));
+  }
+  parts = sp_server_serialize(&parts_size, snap.private_data,
+                              snap.cluster_name, snap.spData,
+                              snap.partition_count, &(snap.strings));
+  sp_server_publish(s, v, snap.private_data, parts, parts_size, &ujl);
+  sp_snap_unmap(&snap);
+}
+
+/* Refreshes the views in every SPART_SERVER_INTERVAL seconds. The views,
+ * which are added by the clients, are loaded at the next refresh. */
+void *sp_server_refresher(void *arg) {
+  sp_server_t *s = (sp_server_t *)arg;
+  int k, count;
+
+  for (;;) {
+    pthread_mutex_lock(&(s->lock));
+    count = s->view_count;
+    pthread_mutex_unlock(&(s->lock));
+    for (k = 0; k < count; k++) {
+      if (s->snapshot_file != NULL)
+        sp_server_load(s, &(s->views[k]), s->snapshot_file);
+      else
+        sp_server_refresh(s, &(s->views[k]));
+    }
+    sleep(SPART_SERVER_INTERVAL);
+  }
+  return NULL;
+}
+
+/* Makes the answer of a client from the last refresh: the partitions, and
+ * the job counts of the client user. Returns 0, if the server has no data
+ * for the query, so the connection is closed without an answer, and the
+ * client asks the slurmctld. */
+int sp_server_answer(sp_server_t *s, sp_server_client_t *c) {
+  sp_server_view_t *v = NULL;
+  sp_snap_writer_t w;
+  uint32_t first, last;
+  int k, rc = 0;
+
+  if ((c->q.magic != SPART_SERVER_MAGIC) ||
+      (c->q.version != SPART_SNAPSHOT_VERSION) ||
+      (c->q.show_partition > 0xffff))
+    return 0;
+
+  pthread_mutex_lock(&(s->lock));
+  for (k = 0; k < s->view_count; k++)
+    if (s->views[k].show_partition == c->q.show_partition) v = &(s->views[k]);
+  if (v == NULL) {
+    /* the new view is loaded at the next refresh */
+    if (s->view_count < SPART_SERVER_VIEW_COUNT) {
+      s->views[s->view_count].show_partition = c->q.show_partition;
+      s->view_count++;
+    }
+  } else if ((v->parts != NULL) && (v->private_data == 0)) {
+    /* the data depends on the user, if the slurm has info restrictions */
+    first = sp_user_jobs_first(v->user_jobs.items, v->user_jobs.count,
+                               c->user_id);
+    for (last = first; (last < v->user_jobs.count) &&
+                       (v->user_jobs.items[last].user_id == c->user_id);
+         last++)
+      ;
+    w.fo = open_memstream(&(c->answer), &(c->answer_size));
+    if (w.fo != NULL) {
+      w.offset = 0;
+      sp_snap_put(&w, v->parts, v->parts_size);
+      sp_snap_write_user_jobs(&w, v->user_jobs.items + first, last - first);
+      rc = (fclose(w.fo) == 0);
+    }
+  }
+  pthread_mutex_unlock(&(s->lock));
+  return rc;
+}
+
+/* Accepts a client. The user of the client is taken from the socket, not
+ * from its query. Returns 0, if the client is not accepted. */
+int sp_server_accept(int sfd, sp_server_client_t *c) {
+#ifdef SO_PEERCRED
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+#else
+  uid_t uid;
+  gid_t gid;
+#endif
+
+  memset(c, 0, sizeof(sp_server_client_t));
+  c->fd = accept(sfd, NULL, NULL);
+  if (c->fd < 0) return 0;
+#ifdef SO_PEERCRED
+  if ((getsockopt(c->fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) ||
+      (len != sizeof(cred))) {
+    close(c->fd);
+    return 0;
+  }
+  c->user_id = cred.uid;
+#else
+  if (getpeereid(c->fd, &uid, &gid) != 0) {
+    close(c->fd);
+    return 0;
+  }
+  c->user_id = uid;
+#endif
+  /* a slow client can not block the server */
+  fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) | O_NONBLOCK);
+  c->deadline = sp_time_now() + SPART_SERVER_CLIENT_TIMEOUT;
+  return 1;
+}
+
+/* Reads the query, or sends the answer as much as the socket accepts.
+ * Returns 0, if the client is done. */
+int sp_server_serve(sp_server_t *s, sp_server_client_t *c) {
+  ssize_t n;
+
+  if (c->received < sizeof(c->q)) {
+    n = recv(c->fd, (char *)&(c->q) + c->received,
+             sizeof(c->q) - c->received, 0);
+    if (n <= 0) return ((n < 0) && (errno == EAGAIN || errno == EINTR));
+    c->received += n;
+    if (c->received < sizeof(c->q)) return 1;
+    if (!sp_server_answer(s, c)) return 0;
+  }
+  while (c->sent < c->answer_size) {
+    n = send(c->fd, c->answer + c->sent, c->answer_size - c->sent, 0);
+    if (n < 0) return ((errno == EAGAIN) || (errno == EINTR));
+    c->sent += n;
+  }
+  return 0;
+}
+
+void sp_server_close(sp_server_client_t *c) {
+  close(c->fd);
+  free(c->answer);
+  memset(c, 0, sizeof(sp_server_client_t));
+  c->fd = -1;
+}
+
+/* Runs the spart server. If snapshot_file is not NULL, the data is read
+ * from this file instead of the slurmctld. */
+void sp_server_run(const char *snapshot_file) {
+  static sp_server_t server;
+  sp_server_client_t clients[SPART_SERVER_CLIENT_COUNT];
+  struct pollfd pfds[SPART_SERVER_CLIENT_COUNT + 1];
+  struct sockaddr_un addr;
+  pthread_t refresher;
+  double now;
+  int sfd, k, accepting, count = 0;
+
+  memset(&server, 0, sizeof(server));
+  server.views[0].show_partition = SHOW_ALL;
+  server.view_count = 1;
+  server.snapshot_file = snapshot_file;
+  pthread_mutex_init(&(server.lock), NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  sp_strn2cpy(addr.sun_path, sizeof(addr.sun_path), SPART_SERVER_SOCKET,
+              sizeof(addr.sun_path));
+  sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sfd < 0) {
+    fprintf(stderr, "Can not create the server socket: %s\n", strerror(errno));
+    exit(1);
+  }
+  unlink(SPART_SERVER_SOCKET);
+  if ((bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) != 0) ||
+      (listen(sfd, 64) != 0)) {
+    fprintf(stderr, "Can not listen %s: %s\n", SPART_SERVER_SOCKET,
+            strerror(errno));
+    exit(1);
+  }
+  /* all users can connect */
+  chmod(SPART_SERVER_SOCKET, 0666);
+
+  /* the slurmctld is asked by the refresh thread, so a slow slurmctld
+   * does not delay the clients */
+  if (pthread_create(&refresher, NULL, sp_server_refresher, &server) != 0) {
+    fprintf(stderr, "Can not start the refresh thread: %s\n",
+            strerror(errno));
+    exit(1);
+  }
+
+  for (;;) {
+    /* the new clients wait in the listen queue, if all slots are used */
+    for (k = 0; k < count; k++) {
+      pfds[k].fd = clients[k].fd;
+      pfds[k].events = (clients[k].received < sizeof(clients[k].q))
+                           ? POLLIN
+                           : POLLOUT;
+      pfds[k].revents = 0;
+    }
+    pfds[count].fd = (count < SPART_SERVER_CLIENT_COUNT) ? sfd : -1;
+    pfds[count].events = POLLIN;
+    pfds[count].revents = 0;
+    if (poll(pfds, count + 1,
+             (count > 0) ? (int)(SPART_SERVER_CLIENT_TIMEOUT * 1000) : -1) <
+        0)
+      continue;
+
+    now = sp_time_now();
+    accepting = (pfds[count].revents & POLLIN);
+    for (k = count - 1; k >= 0; k--) {
+      if ((now < clients[k].deadline) &&
+          ((!pfds[k].revents) || (sp_server_serve(&server, &(clients[k])))))
+        continue;
+      sp_server_close(&(clients[k]));
+      /* the last client is moved to the free slot */
+      count--;
+      clients[k] = clients[count];
+    }
+    if ((accepting) && (sp_server_accept(sfd, &(clients[count])))) count++;
+  }
+}
+
+/* Asks the partitions to the spart server. Returns 1 on success, 0 if the
+ * server is not running, or it can not answer. */
+int sp_server_query(const char *socket_path, uint16_t show_partition,
+                    sp_snapshot_t *snap) {
+  struct timeval tv = {5, 0};
+  struct sockaddr_un addr;
+  sp_server_query_t q;
+  char *buf = NULL, *tmp;
+  size_t size = 0, cap = 0;
+  ssize_t n = 0;
+  int fd;
+
+  memset(snap, 0, sizeof(sp_snapshot_t));
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  sp_strn2cpy(addr.sun_path, sizeof(addr.sun_path), socket_path,
+              sizeof(addr.sun_path));
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return 0;
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return 0;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  q.magic = SPART_SERVER_MAGIC;
+  q.version = SPART_SNAPSHOT_VERSION;
+  q.show_partition = show_partition;
+  if (send(fd, &q, sizeof(q), 0) != sizeof(q)) {
+    close(fd);
+    return 0;
+  }
+
+  for (;;) {
+    if (size == cap) {
+      cap = (cap == 0) ? 65536 : cap * 2;
+      tmp = realloc(buf, cap);
+      if (tmp == NULL) {
+        n = -1;
+        break;
+      }
+      buf = tmp;
+    }
+    n = recv(fd, buf + size, cap - size, 0);
+    if (n <= 0) break;
+    size += n;
+  }
+  close(fd);
+
+  if ((n < 0) || (!sp_snap_parse(snap, buf, size))) {
+    free(buf);
+    memset(snap, 0, sizeof(sp_snapshot_t));
+    return 0;
+  }
+  snap->buffer = buf;
+  return 1;
+}
+
+#endif /* SPART_SERVER_SOCKET */
+
+#endif /* SPART_SPART_SERVER_H_incl */
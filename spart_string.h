@@ -8,7 +8,16 @@
 #ifndef SPART_SPART_STRING_H_incl
 #define SPART_SPART_STRING_H_incl
 
+#include <errno.h>
+#include <fcntl.h>
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 size_t sp_str_available(char *s, size_t maxlen) {
   size_t filled = strnlen(s, maxlen);
@@ -46,32 +55,24 @@ char *sp_strn2cpy(char *dest, size_t ndest, const char *src, size_t nsrc) {
   return strncpy(dest, src, available);
 }
 
-/* Checks the user accounts present at the partition accounts */
-/* Search each of the keys in a string which contains comma seperated keys */
-int sp_account_check(char **key_list, int key_count, char *comma_sep_str) {
-  uint16_t i;
-  int *found = NULL;
-  int parti = 0;
-  char *strtmp = NULL;
-  char *grestok;
-
-  found = malloc(key_count * sizeof(int));
-  for (i = 0; i < key_count; i++) found[i] = 0;
-
-  for (grestok = strtok_r(comma_sep_str, ",", &strtmp); grestok != NULL;
-       grestok = strtok_r(NULL, ",", &strtmp)) {
-    for (i = 0; i < key_count; i++) {
-      if (strncmp(key_list[i], grestok, SPART_INFO_STRING_SIZE) == 0) {
-        found[i]++;
-        break;
-      }
-    }
+/* Returns the next token of a seperated list without modifying the list,
+ * and sets its length. Empty tokens are skipped, as strtok_r does.
+ * Returns NULL at the end of the list. */
+const char *sp_token_next(const char **cursor, char sep, uint32_t *len) {
+  const char *tok = *cursor;
+  const char *end;
+
+  if (tok == NULL) return NULL;
+  while (*tok == sep) tok++;
+  if (*tok == '\0') {
+    *cursor = tok;
+    return NULL;
   }
-  /* How many accounts/groups of user listed in the partition list */
-  for (i = 0; i < key_count; i++)
-    if (found[i] > 0) parti++;
-  free(found);
-  return parti;
+  end = strchr(tok, sep);
+  if (end == NULL) end = tok + strlen(tok);
+  *len = (uint32_t)(end - tok);
+  *cursor = end;
+  return tok;
 }
 
 /* Search for chr in str. If not fund, adds chr to str. */
@@ -88,4 +89,222 @@ void sp_char_check(char *str, int nstr, const char *chr, int nchr) {
   }
 }
 
+/* Condensed printing for big numbers (k,m) to the string */
+void sp_con_strprint(char *str, uint16_t size, uint32_t num) {
+  char cresult[SPART_MAX_COLUMN_SIZE];
+  snprintf(cresult, SPART_MAX_COLUMN_SIZE, "%d", num);
+  switch (strlen(cresult)) {
+    case 5:
+    case 6:
+      snprintf(str, size, "%d%s", (uint32_t)(num / 1000), "k");
+      break;
+
+    case 7:
+      snprintf(str, size, "%.1f%s", (float)(num / 1000000.0f), "m");
+      break;
+
+    case 8:
+    case 9:
+      snprintf(str, size, "%d%s", (uint32_t)(num / 1000000), "m");
+      break;
+
+    case 10:
+      snprintf(str, size, "%.1f%s", (float)(num / 1000000000.0f), "g");
+      break;
+
+    case 11:
+    case 12:
+      snprintf(str, size, "%d%s", (uint32_t)(num / 1000000000), "g");
+      break;
+
+    default:
+      snprintf(str, size, "%d", num);
+  }
+}
+
+/* A growing string, which knows its length, so appending does not scan
+ * the string again */
+typedef struct sp_strbuf {
+  char *data;
+  size_t len;
+  size_t size;
+} sp_strbuf_t;
+
+void sp_strbuf_init(sp_strbuf_t *sb) {
+  sb->size = 1024;
+  sb->len = 0;
+  sb->data = malloc(sb->size);
+  if (sb->data == NULL) {
+    slurm_perror("Can not allocate output buffer");
+    exit(1);
+  }
+  sb->data[0] = 0;
+}
+
+void sp_strbuf_free(sp_strbuf_t *sb) {
+  free(sb->data);
+  sb->data = NULL;
+  sb->len = 0;
+  sb->size = 0;
+}
+
+/* Empties the string, and keeps its memory */
+void sp_strbuf_clear(sp_strbuf_t *sb) {
+  sb->len = 0;
+  sb->data[0] = 0;
+}
+
+/* Makes room for more chars and the terminating zero */
+void sp_strbuf_reserve(sp_strbuf_t *sb, size_t more) {
+  if (sb->len + more + 1 <= sb->size) return;
+  while (sb->len + more + 1 > sb->size) sb->size *= 2;
+  sb->data = realloc(sb->data, sb->size);
+  if (sb->data == NULL) {
+    slurm_perror("Can not allocate output buffer");
+    exit(1);
+  }
+}
+
+void sp_strbuf_catn(sp_strbuf_t *sb, const char *str, size_t len) {
+  sp_strbuf_reserve(sb, len);
+  memcpy(sb->data + sb->len, str, len);
+  sb->len += len;
+  sb->data[sb->len] = 0;
+}
+
+void sp_strbuf_cat(sp_strbuf_t *sb, const char *str) {
+  sp_strbuf_catn(sb, str, strlen(str));
+}
+
+/* Appends count times the char */
+void sp_strbuf_pad(sp_strbuf_t *sb, char ch, size_t count) {
+  sp_strbuf_reserve(sb, count);
+  memset(sb->data + sb->len, ch, count);
+  sb->len += count;
+  sb->data[sb->len] = 0;
+}
+
+/* Appends the string right aligned to the width, as "%*s" */
+void sp_strbuf_right(sp_strbuf_t *sb, const char *str, size_t len,
+                     size_t width) {
+  if (len < width) sp_strbuf_pad(sb, ' ', width - len);
+  sp_strbuf_catn(sb, str, len);
+}
+
+/* Appends the string left aligned to the width, as "%-*s" */
+void sp_strbuf_left(sp_strbuf_t *sb, const char *str, size_t len,
+                    size_t width) {
+  sp_strbuf_catn(sb, str, len);
+  if (len < width) sp_strbuf_pad(sb, ' ', width - len);
+}
+
+/* Writes the string to the file descriptor with as few write calls as the
+ * system allows, and empties it */
+void sp_strbuf_write(sp_strbuf_t *sb, int fd) {
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < sb->len) {
+    n = write(fd, sb->data + done, sb->len - done);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    done += n;
+  }
+  sp_strbuf_clear(sb);
+}
+
+/* Writes the number as "%d" to str, which should have 24 chars. Returns
+ * the char count. */
+size_t sp_int_str(char *str, int64_t num) {
+  char tmp[24];
+  size_t n = 0, k;
+  uint64_t u = (num < 0) ? -(uint64_t)num : (uint64_t)num;
+
+  do {
+    tmp[n++] = '0' + (u % 10);
+    u /= 10;
+  } while (u);
+  if (num < 0) tmp[n++] = '-';
+  for (k = 0; k < n; k++) str[k] = tmp[n - 1 - k];
+  str[n] = 0;
+  return n;
+}
+
+/* Appends the number right aligned to the width, as "%*d", or as "%0*d"
+ * if pad is '0' */
+void sp_strbuf_int(sp_strbuf_t *sb, int64_t num, size_t width, char pad) {
+  char str[24];
+  size_t n = sp_int_str(str, num);
+  if (n < width) sp_strbuf_pad(sb, pad, width - n);
+  sp_strbuf_catn(sb, str, n);
+}
+
+/* Appends a positive value with one decimal, right aligned to the width,
+ * as "%*.1f". The value is rounded as the printf does. */
+void sp_strbuf_float1(sp_strbuf_t *sb, float value, size_t width) {
+  /* a float times ten is exact as a double */
+  double d = (double)value * 10.0;
+  uint64_t tenths = (uint64_t)d;
+  double frac = d - (double)tenths;
+  char str[32];
+  size_t n;
+
+  if ((frac > 0.5) || ((frac == 0.5) && (tenths & 1))) tenths++;
+  n = sp_int_str(str, tenths / 10);
+  str[n++] = '.';
+  str[n++] = '0' + (tenths % 10);
+  str[n] = 0;
+  sp_strbuf_right(sb, str, n, width);
+}
+
+/* Appends a formatted string */
+void sp_strbuf_printf(sp_strbuf_t *sb, const char *format, ...) {
+  va_list ap;
+  int n;
+
+  va_start(ap, format);
+  n = vsnprintf(sb->data + sb->len, sb->size - sb->len, format, ap);
+  va_end(ap);
+  if (n < 0) return;
+  if (sb->len + n + 1 > sb->size) {
+    sp_strbuf_reserve(sb, n);
+    va_start(ap, format);
+    vsnprintf(sb->data + sb->len, sb->size - sb->len, format, ap);
+    va_end(ap);
+  }
+  sb->len += n;
+}
+
+/* Writes the buffer to a temporary file, and renames it to the path, so
+ * the readers never see a partial file. Returns 0 on error. */
+int sp_strbuf_save(sp_strbuf_t *sb, const char *path) {
+  char tmp_path[SPART_INFO_STRING_SIZE];
+  int fd;
+  FILE *fo;
+
+  snprintf(tmp_path, SPART_INFO_STRING_SIZE, "%s.%d", path, (int)getpid());
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0644);
+  if (fd < 0) return 0;
+  fo = fdopen(fd, "w");
+  if (fo == NULL) {
+    close(fd);
+    unlink(tmp_path);
+    return 0;
+  }
+  fwrite(sb->data, 1, sb->len, fo);
+  if ((fflush(fo) != 0) || ferror(fo)) {
+    fclose(fo);
+    unlink(tmp_path);
+    return 0;
+  }
+  fclose(fo);
+  if (rename(tmp_path, path) != 0) {
+    unlink(tmp_path);
+    return 0;
+  }
+  return 1;
+}
+
 #endif /* SPART_SPART_STRING_H_incl */
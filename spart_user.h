@@ -0,0 +1,440 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_USER_H_incl
+#define SPART_SPART_USER_H_incl
+
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+#include <slurm/slurmdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "spart.h"
+#include "spart_hash.h"
+#include "spart_string.h"
+
+/* Reads the name and the id of the user. The groups are read later by
+ * sp_user_groups_get, only if they are needed. */
+void sp_user_get(sp_user_info_t *user, uid_t uid) {
+  struct passwd *pw;
+
+  memset(user, 0, sizeof(sp_user_info_t));
+  pw = getpwuid(uid);
+  if (pw == NULL) {
+    slurm_perror("Can not read User info");
+    exit(1);
+  }
+  sp_strn2cpy(user->user_name, SPART_INFO_STRING_SIZE, pw->pw_name,
+              SPART_INFO_STRING_SIZE);
+  user->user_id = pw->pw_uid;
+  user->group_id = pw->pw_gid;
+}
+
+/* Reads the group names of the user. Returns 0, or the error number. */
+int sp_user_groups_get(sp_user_info_t *user) {
+  int k, count = SPART_MAX_GROUP_SIZE;
+  gid_t *groupIDs = NULL;
+  struct group *gr;
+
+  groupIDs = malloc(count * sizeof(gid_t));
+  if (groupIDs == NULL) return ENOMEM;
+
+  if (getgrouplist(user->user_name, user->group_id, groupIDs, &count) == -1) {
+    free(groupIDs);
+    return ERANGE;
+  }
+
+  user->user_group = sp_arena_alloc(&(user->group_arena),
+                                    (count + 1) * sizeof(char *));
+  user->user_group_count = 0;
+  for (k = 0; k < count; k++) {
+    gr = getgrgid(groupIDs[k]);
+    if (gr != NULL) {
+      user->user_group[user->user_group_count] =
+          sp_arena_strdup(&(user->group_arena), gr->gr_name);
+      user->user_group_count++;
+    }
+  }
+
+  free(groupIDs);
+  return 0;
+}
+
+/* Builds the set of a user list. The names are not copied. */
+void sp_user_set_build(sp_user_set_t *set, char **list, int count) {
+  uint32_t *slot;
+  int k;
+
+  sp_hash_init(&(set->names), count);
+  sp_hash_init(&(set->results), 16);
+  set->count = 0;
+  set->stamp = 0;
+  for (k = 0; k < count; k++) {
+    slot = sp_hash_slot(&(set->names), list[k], strlen(list[k]));
+    /* an account may have the same QOS with an other account */
+    if (*slot == SPART_HASH_EMPTY) *slot = set->count++;
+  }
+  set->seen = calloc(set->count + 1, sizeof(uint32_t));
+  if (set->seen == NULL) {
+    slurm_perror("Can not allocate user set");
+    exit(1);
+  }
+}
+
+void sp_user_set_free(sp_user_set_t *set) {
+  sp_hash_free(&(set->names));
+  sp_hash_free(&(set->results));
+  free(set->seen);
+  memset(set, 0, sizeof(sp_user_set_t));
+}
+
+/* Builds the sets of the accounts, the QOSs and the groups */
+void sp_user_sets_build(sp_user_info_t *user) {
+  sp_user_set_build(&(user->acct_set), user->user_acct, user->user_acct_count);
+  sp_user_set_build(&(user->qos_set), user->user_qos, user->user_qos_count);
+  sp_user_set_build(&(user->group_set), user->user_group,
+                    user->user_group_count);
+}
+
+/* Frees the sets, the lists are kept */
+void sp_user_sets_free(sp_user_info_t *user) {
+  sp_user_set_free(&(user->acct_set));
+  sp_user_set_free(&(user->qos_set));
+  sp_user_set_free(&(user->group_set));
+}
+
+/* Frees the account and QOS lists of the user */
+void sp_user_free_assoc(sp_user_info_t *user) {
+  sp_user_set_free(&(user->acct_set));
+  sp_user_set_free(&(user->qos_set));
+  sp_arena_free(&(user->assoc_arena));
+  user->user_acct = NULL;
+  user->user_acct_count = 0;
+  user->user_qos = NULL;
+  user->user_qos_count = 0;
+}
+
+/* Frees the group, account and QOS lists of the user */
+void sp_user_free(sp_user_info_t *user) {
+  sp_user_free_assoc(user);
+  sp_user_set_free(&(user->group_set));
+  sp_arena_free(&(user->group_arena));
+  user->user_group = NULL;
+  user->user_group_count = 0;
+}
+
+/* Adds a name to a list in the arena. The list is moved to a two times
+ * bigger array, when its count reaches a power of two. */
+void sp_user_list_add(sp_arena_t *arena, char ***list, int *count,
+                      const char *name) {
+  char **grown;
+
+  if ((*count & (*count - 1)) == 0) {
+    grown = sp_arena_alloc(arena, (*count ? *count * 2 : 1) * sizeof(char *));
+    if (*count) memcpy(grown, *list, *count * sizeof(char *));
+    *list = grown;
+  }
+  (*list)[*count] = sp_arena_strdup(arena, name);
+  (*count)++;
+}
+
+/* Reads the accounts and the QOSs of the users from the slurm database,
+ * with one query for all of them. The lists are allocated in the arena.
+ * Returns 0, or the slurm error number if the database can not be used. */
+int sp_user_assoc_get(sp_arena_t *arena, sp_user_info_t *users, int count) {
+  sp_hash_t names;
+  sp_user_info_t *user;
+  uint32_t *slot, found;
+  int k, rc = 0;
+
+  /* the records of the query are matched to the users by their names */
+  sp_hash_init(&names, count);
+  for (k = 0; k < count; k++) {
+    users[k].user_acct = NULL;
+    users[k].user_acct_count = 0;
+    users[k].user_qos = NULL;
+    users[k].user_qos_count = 0;
+    slot = sp_hash_slot(&names, users[k].user_name,
+                        strlen(users[k].user_name));
+    if (*slot == SPART_HASH_EMPTY) *slot = k;
+  }
+
+#if SLURM_VERSION_NUMBER > SLURM_VERSION_NUM(18, 7, 0) &&  \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 0) && \
+    SLURM_VERSION_NUMBER != SLURM_VERSION_NUM(20, 2, 1)
+  int m, n;
+  void *db_conn = NULL;
+  slurmdb_assoc_cond_t assoc_cond;
+  List assoc_list = NULL;
+  ListIterator itr = NULL;
+
+  slurmdb_assoc_rec_t *assoc;
+
+  List qos_list = NULL;
+  ListIterator itr_qos = NULL;
+
+  char *qos = NULL;
+
+#if SLURM_VERSION_NUMBER >= SLURM_VERSION_NUM(20, 11, 0)
+  db_conn = slurmdb_connection_get(NULL);
+#else
+  db_conn = slurmdb_connection_get();
+#endif
+  if (errno != SLURM_SUCCESS) {
+    rc = errno;
+    sp_hash_free(&names);
+    return rc;
+  }
+
+  memset(&assoc_cond, 0, sizeof(slurmdb_assoc_cond_t));
+  assoc_cond.user_list = slurm_list_create(NULL);
+  for (k = 0; k < count; k++)
+    slurm_list_append(assoc_cond.user_list, users[k].user_name);
+  assoc_cond.acct_list = slurm_list_create(NULL);
+
+  assoc_list = slurmdb_associations_get(db_conn, &assoc_cond);
+  itr = slurm_list_iterator_create(assoc_list);
+
+  for (n = slurm_list_count(assoc_list); n > 0; n--) {
+    assoc = slurm_list_next(itr);
+    if (assoc->user == NULL) continue;
+    found = sp_hash_get(&names, assoc->user, strlen(assoc->user));
+    if (found == SPART_HASH_EMPTY) continue;
+    user = &(users[found]);
+    sp_user_list_add(arena, &(user->user_acct), &(user->user_acct_count),
+                     assoc->acct);
+
+    /* the QOSs of all associations */
+    qos_list = assoc->qos_list;
+    m = slurm_list_count(qos_list);
+    if (m > 0) {
+      itr_qos = slurm_list_iterator_create(qos_list);
+      for (; m > 0; m--) {
+        qos = slurm_list_next(itr_qos);
+        sp_user_list_add(arena, &(user->user_qos), &(user->user_qos_count),
+                         qos);
+      }
+      slurm_list_iterator_destroy(itr_qos);
+    }
+  }
+
+  slurm_list_iterator_destroy(itr);
+  slurm_list_destroy(assoc_list);
+  slurm_list_destroy(assoc_cond.user_list);
+  slurm_list_destroy(assoc_cond.acct_list);
+  slurmdb_connection_close(&db_conn);
+#else
+  /* The slurmdb api of these versions is not usable, so the sacctmgr is
+   * run once for the accounts and the QOSs, without a shell */
+  char *argv[] = {"sacctmgr", "-n", "-P", "list", "association",
+                  "format=user,account,qos", "where", NULL, NULL};
+  sp_strbuf_t user_cond;
+  char *line = NULL;
+  size_t nline = 0;
+  ssize_t len;
+  char *a_str = NULL;
+  char *p_str = NULL;
+  char *t_str = NULL;
+  char *m_str = NULL;
+  int fds[2], status, fd;
+  pid_t pid;
+  FILE *fo;
+
+  sp_strbuf_init(&user_cond);
+  sp_strbuf_cat(&user_cond, "user=");
+  for (k = 0; k < count; k++) {
+    if (k > 0) sp_strbuf_catn(&user_cond, ",", 1);
+    sp_strbuf_cat(&user_cond, users[k].user_name);
+  }
+  argv[7] = user_cond.data;
+
+  if (pipe(fds) != 0) {
+    rc = errno;
+    sp_strbuf_free(&user_cond);
+    sp_hash_free(&names);
+    return rc;
+  }
+  pid = fork();
+  if (pid < 0) {
+    rc = errno;
+    close(fds[0]);
+    close(fds[1]);
+    sp_strbuf_free(&user_cond);
+    sp_hash_free(&names);
+    return rc;
+  }
+  if (pid == 0) {
+    dup2(fds[1], STDOUT_FILENO);
+    fd = open("/dev/null", O_WRONLY);
+    if (fd >= 0) dup2(fd, STDERR_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+    execvp(argv[0], argv);
+    _exit(127);
+  }
+  close(fds[1]);
+  sp_strbuf_free(&user_cond);
+
+  /* each line is "user|account|qos1,qos2,..." */
+  fo = fdopen(fds[0], "r");
+  if (fo != NULL) {
+    while ((len = getline(&line, &nline, fo)) > 0) {
+      if (line[len - 1] == '\n') line[len - 1] = '\0';
+      a_str = strchr(line, '|');
+      if (a_str == NULL) continue;
+      *(a_str++) = '\0';
+      found = sp_hash_get(&names, line, strlen(line));
+      if (found == SPART_HASH_EMPTY) continue;
+      user = &(users[found]);
+      t_str = strchr(a_str, '|');
+      if (t_str != NULL) *(t_str++) = '\0';
+      if (a_str[0] != '\0')
+        sp_user_list_add(arena, &(user->user_acct), &(user->user_acct_count),
+                         a_str);
+      if (t_str == NULL) continue;
+      for (p_str = strtok_r(t_str, ",", &m_str); p_str != NULL;
+           p_str = strtok_r(NULL, ",", &m_str))
+        sp_user_list_add(arena, &(user->user_qos), &(user->user_qos_count),
+                         p_str);
+    }
+    free(line);
+    fclose(fo);
+  } else {
+    close(fds[0]);
+  }
+
+  while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR))
+    ;
+  /* the lists are freed with the arena */
+  if ((fo == NULL) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    rc = SLURM_ERROR;
+#endif
+
+  sp_hash_free(&names);
+  return rc;
+}
+
+#ifdef SPART_ASSOC_CACHE_TTL
+/* The association cache file of the user */
+void sp_assoc_cache_path(char *path, size_t npath, uid_t uid) {
+  snprintf(path, npath, "%sspart_assoc_%u", SPART_ASSOC_CACHE_DIR,
+           (unsigned)uid);
+}
+
+/* Reads the accounts and the QOSs of the user from the cache file. The file
+ * should belong to the user, should not be readable by others, and should
+ * be younger than SPART_ASSOC_CACHE_TTL seconds. Returns 1 on success. */
+int sp_assoc_cache_read(sp_user_info_t *user) {
+  char path[SPART_INFO_STRING_SIZE];
+  struct stat st;
+  char *line = NULL;
+  size_t nline = 0;
+  ssize_t len;
+  int fd, valid = 0;
+  FILE *fi;
+
+  sp_assoc_cache_path(path, SPART_INFO_STRING_SIZE, geteuid());
+  fd = open(path, O_RDONLY | O_NOFOLLOW);
+  if (fd < 0) return 0;
+  if ((fstat(fd, &st) != 0) || (st.st_uid != geteuid()) ||
+      (st.st_mode & 077) || (st.st_mtime + SPART_ASSOC_CACHE_TTL < time(NULL))) {
+    close(fd);
+    return 0;
+  }
+  fi = fdopen(fd, "r");
+  if (fi == NULL) {
+    close(fd);
+    return 0;
+  }
+
+  while ((len = getline(&line, &nline, fi)) > 0) {
+    if (line[len - 1] == '\n') line[len - 1] = '\0';
+    if (!valid) {
+      /* the first line is the user name */
+      if ((strncmp(line, "user ", 5) != 0) ||
+          (strcmp(line + 5, user->user_name) != 0))
+        break;
+      valid = 1;
+    } else if (strncmp(line, "acct ", 5) == 0) {
+      sp_user_list_add(&(user->assoc_arena), &(user->user_acct),
+                       &(user->user_acct_count), line + 5);
+    } else if (strncmp(line, "qos ", 4) == 0) {
+      sp_user_list_add(&(user->assoc_arena), &(user->user_qos),
+                       &(user->user_qos_count), line + 4);
+    } else if (strcmp(line, "end") == 0) {
+      valid = 2;
+    }
+  }
+  free(line);
+  fclose(fi);
+
+  /* a truncated or foreign file is not used */
+  if (valid != 2) {
+    sp_user_free_assoc(user);
+    return 0;
+  }
+  return 1;
+}
+
+/* Writes the accounts and the QOSs of the user to the cache file */
+void sp_assoc_cache_write(sp_user_info_t *user) {
+  char path[SPART_INFO_STRING_SIZE];
+  char tmp_path[SPART_INFO_STRING_SIZE + 16];
+  int k, fd;
+  FILE *fo;
+
+  sp_assoc_cache_path(path, SPART_INFO_STRING_SIZE, geteuid());
+  snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+  fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+  if (fd < 0) return;
+  fo = fdopen(fd, "w");
+  if (fo == NULL) {
+    close(fd);
+    unlink(tmp_path);
+    return;
+  }
+  fprintf(fo, "user %s\n", user->user_name);
+  for (k = 0; k < user->user_acct_count; k++)
+    fprintf(fo, "acct %s\n", user->user_acct[k]);
+  for (k = 0; k < user->user_qos_count; k++)
+    fprintf(fo, "qos %s\n", user->user_qos[k]);
+  fprintf(fo, "end\n");
+  if ((fflush(fo) != 0) || ferror(fo)) {
+    fclose(fo);
+    unlink(tmp_path);
+    return;
+  }
+  fclose(fo);
+  if (rename(tmp_path, path) != 0) unlink(tmp_path);
+}
+#endif
+
+/* Reads the accounts and the QOSs of the user, from the cache if it is
+ * fresh. If refresh is set, the cache is not used, but it is updated.
+ * Returns 0, or the slurm error number. */
+int sp_user_assoc_load(sp_user_info_t *user, int refresh) {
+  int rc;
+#ifdef SPART_ASSOC_CACHE_TTL
+  if ((!refresh) && (sp_assoc_cache_read(user))) return 0;
+#endif
+  rc = sp_user_assoc_get(&(user->assoc_arena), user, 1);
+#ifdef SPART_ASSOC_CACHE_TTL
+  if (rc == 0) sp_assoc_cache_write(user);
+#endif
+  return rc;
+}
+
+#endif /* SPART_SPART_USER_H_incl */
@@ -0,0 +1,160 @@
+/******************************************************************
+ * spart    : a user-oriented partition info command for slurm
+ * Author   : Cem Ahmet Mercan, 2019-02-16
+ * Licence  : GNU General Public License v2.0
+ * Note     : Some part of this code taken from slurm api man pages
+ *******************************************************************/
+
+#ifndef SPART_SPART_WATCH_H_incl
+#define SPART_SPART_WATCH_H_incl
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "spart_fetch.h"
+#include "spart_string.h"
+
+/* The state of the --watch mode. The last frame is kept, so only the
+ * changed parts of the screen are written again. */
+typedef struct sp_watch {
+  int seconds;
+  /* the stdout is a terminal */
+  int tty;
+  /* the monotonic time of the next refresh */
+  double next;
+  /* the output of the last refresh, and the frame on the screen */
+  sp_strbuf_t body;
+  sp_strbuf_t screen;
+  sp_strbuf_t frame;
+  sp_strbuf_t out;
+} sp_watch_t;
+
+/* The lines are not wrapped while watching, so the line numbers of the
+ * frame are the rows of the screen. The terminal is set back at exit. */
+void sp_watch_restore(int sig) {
+  const char *reset = "\033[?7h\n";
+  if (write(STDOUT_FILENO, reset, strlen(reset)) < 0) _exit(1);
+  _exit(0);
+}
+
+void sp_watch_init(sp_watch_t *w, int seconds) {
+  w->seconds = seconds;
+  w->tty = isatty(STDOUT_FILENO);
+  w->next = sp_time_now() + seconds;
+  sp_strbuf_init(&(w->body));
+  sp_strbuf_init(&(w->screen));
+  sp_strbuf_init(&(w->frame));
+  sp_strbuf_init(&(w->out));
+  if (w->tty) {
+    signal(SIGINT, sp_watch_restore);
+    signal(SIGTERM, sp_watch_restore);
+    signal(SIGHUP, sp_watch_restore);
+  }
+}
+
+void sp_watch_free(sp_watch_t *w) {
+  sp_strbuf_free(&(w->body));
+  sp_strbuf_free(&(w->screen));
+  sp_strbuf_free(&(w->frame));
+  sp_strbuf_free(&(w->out));
+}
+
+/* Sleeps until the next refresh. A slow refresh does not shift the
+ * following ones, but the missed ones are skipped. */
+void sp_watch_wait(sp_watch_t *w) {
+  struct timespec ts;
+  double now = sp_time_now();
+
+  if (w->next > now) {
+    ts.tv_sec = (time_t)(w->next - now);
+    ts.tv_nsec = (long)((w->next - now - ts.tv_sec) * 1e9);
+    while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR))
+      ;
+  }
+  w->next += w->seconds;
+  now = sp_time_now();
+  if (w->next < now) w->next = now + w->seconds;
+}
+
+/* Returns the length of the line, which starts at str */
+size_t sp_watch_line(const char *str, const char *end) {
+  const char *eol = memchr(str, '\n', end - str);
+  return (eol != NULL) ? (size_t)(eol - str) : (size_t)(end - str);
+}
+
+/* Writes the frame over the last one. Only the lines which are changed
+ * are written, starting from their first changed char. */
+void sp_watch_draw(sp_watch_t *w) {
+  const char *o = w->screen.data, *oend = o + w->screen.len;
+  const char *n = w->frame.data, *nend = n + w->frame.len;
+  size_t olen, nlen, col, k;
+  int row = 1;
+  char move[32];
+
+  /* the first frame is written to the cleared screen */
+  if (w->screen.len == 0) sp_strbuf_cat(&(w->out), "\033[?7l\033[H\033[2J");
+  for (; n < nend; n += nlen + 1, row++) {
+    nlen = sp_watch_line(n, nend);
+    olen = (o < oend) ? sp_watch_line(o, oend) : 0;
+    for (col = 0; (col < nlen) && (col < olen) && (n[col] == o[col]); col++)
+      ;
+    if ((col < nlen) || (col < olen)) {
+      /* the columns of the multibyte chars are not known */
+      for (k = 0; k < col; k++)
+        if (((unsigned char)n[k]) >= 0x80) col = 0;
+      snprintf(move, sizeof(move), "\033[%d;%dH", row, (int)col + 1);
+      sp_strbuf_cat(&(w->out), move);
+      sp_strbuf_catn(&(w->out), n + col, nlen - col);
+      if (olen > nlen) sp_strbuf_cat(&(w->out), "\033[K");
+    }
+    if (o < oend) o += olen + 1;
+  }
+  /* the cursor waits below the frame, the rest of a longer frame is
+   * cleared */
+  snprintf(move, sizeof(move), "\033[%d;1H", row);
+  sp_strbuf_cat(&(w->out), move);
+  if (o < oend) sp_strbuf_cat(&(w->out), "\033[J");
+  sp_strbuf_write(&(w->out), STDOUT_FILENO);
+}
+
+/* Shows the output of a refresh. If out is NULL, the data is not changed,
+ * so the last output is shown with the new time. The note is shown at the
+ * title, or written to the stderr if the stdout is not a terminal. */
+void sp_watch_show(sp_watch_t *w, sp_strbuf_t *out, const char *note) {
+  sp_strbuf_t tmp;
+  char stamp[64];
+  time_t now = time(NULL);
+
+  if (out != NULL) {
+    tmp = w->body;
+    w->body = *out;
+    *out = tmp;
+    sp_strbuf_clear(out);
+  }
+  strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+  sp_strbuf_clear(&(w->frame));
+  sp_strbuf_printf(&(w->frame), "Every %ds: spart  %s", w->seconds, stamp);
+  if ((note != NULL) && (w->tty)) sp_strbuf_printf(&(w->frame), "  %s", note);
+  sp_strbuf_cat(&(w->frame), "\n\n");
+  sp_strbuf_catn(&(w->frame), w->body.data, w->body.len);
+  /* the last line end does not scroll the screen */
+  if ((w->frame.len > 0) && (w->frame.data[w->frame.len - 1] == '\n'))
+    w->frame.data[--(w->frame.len)] = 0;
+
+  if (w->tty) {
+    sp_watch_draw(w);
+    tmp = w->screen;
+    w->screen = w->frame;
+    w->frame = tmp;
+  } else {
+    if (note != NULL) fprintf(stderr, "%s\n", note);
+    if (out == NULL) return;
+    sp_strbuf_catn(&(w->frame), "\n\n", 2);
+    sp_strbuf_write(&(w->frame), STDOUT_FILENO);
+  }
+}
+
+#endif /* SPART_SPART_WATCH_H_incl */